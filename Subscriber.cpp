@@ -13,11 +13,12 @@
 
 #include <iostream>
 #include <string>
+#include <sstream>
 #include "mqtt/async_client.h"
 
 const std::string SERVER_ADDRESS{"tcp://localhost:1883"};
 const std::string CLIENT_ID{"mqtt_cpp_subscriber"};
-const std::string TOPIC{"test_dme"};
+const std::string TOPIC{"test_dme/#"};     // moi node gui len test_dme/<id> (MQTT_TOPIC)
 const int QOS = 1;
 
 class callback : public virtual mqtt::callback
@@ -33,9 +34,14 @@ public:
         std::cout << "Connection lost: " << cause << std::endl;
     }
 
+    // mot ban tin gom nhieu ban ghi log, moi ban ghi mot dong
     void message_arrived(mqtt::const_message_ptr msg) override
     {
-        std::cout << "Message arrived on topic '" << TOPIC << "': " << msg->to_string() << std::endl;
+        std::istringstream records(msg->to_string());
+        std::string record;
+        while (std::getline(records, record)) {
+            std::cout << "Message arrived on topic '" << msg->get_topic() << "': " << record << std::endl;
+        }
     }
 
     void delivery_complete(mqtt::delivery_token_ptr token) override
@@ -35,16 +35,28 @@ private:
     std::mutex mtx;
     std::mutex mtxMsg;
     std::condition_variable cv;
+
+    Dispatcher<Lamport> dispatcher;
+
 public:
     Lamport(int id, const std::string& ip, int port, std::shared_ptr<Comm> comm)
-        : PermissonBasedNode(id, ip, port, comm), globalTimestamp(0), localTimestamp(0) {
-            json note;
-            note["status"] = "null";
-            note["init"] = "ok";
-            note["error"] = "null";
-            note["source"] = "null";
-            note["dest"] = "null";
-            logger->log("notice", id, std::to_string(id) + " init", note);
+        : PermissonBasedNode(id, ip, port, comm), globalTimestamp(0), localTimestamp(0),
+          dispatcher(*this, {
+              {MsgType::REQUEST, [](Lamport &self, const Message &m) {
+                  self.receivedRqt(m.source, m.timestamp);
+                  self.sendAgree(m.source, m.timestamp);
+              }},
+              {MsgType::OK, [](Lamport &self, const Message &m) { self.receivedAgree(m.source, m.timestamp); }},
+              {MsgType::RELEASE, [](Lamport &self, const Message &m) { self.receivedRls(m.source, m.timestamp); }},
+          }) {
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                note["status"] = "null";
+                note["init"] = "ok";
+                note["error"] = "null";
+                note["source"] = "null";
+                note["dest"] = "null";
+                return std::to_string(id) + " init";
+            });
             totalNodes = config.getTotalNodes();
             initialize();
     }
@@ -61,65 +73,65 @@ public:
         localTimestamp = globalTimestamp;
         REQUEST rqt = {id, localTimestamp};
         listRqt.push(rqt);
-        for (int i = 1; i <= totalNodes; i++) {
-            if (i == id) {
-                continue;
-            }
-            comm->send(i, std::to_string(rqt.id) + " REQUEST " + std::to_string(rqt.timestamp)); // id type timestamp
-        }
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = "broadcast";
-        logger->log("send", id, std::to_string(id) + " sent request broadcast", note);
+        comm->broadcast(Message(MsgType::REQUEST, rqt.id, rqt.timestamp));
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = "broadcast";
+            return std::to_string(id) + " sent request broadcast";
+        });
         cv.wait(lock, [this]() { 
             return (listReply.size() == totalNodes - 1) && (listRqt.top().id == id); 
         });
     }
 
+    DispatchStats getDispatchStats() const override {
+        return dispatcher.getStats();
+    }
+
     void releasePermission() override {
         std::unique_lock<std::mutex> lock(mtx);
         listRqt.pop();
         listReply.clear();
-        for (int i = 1; i <= totalNodes; i++) {
-            if (i == id) {
-                continue;
-            }
-            comm->send(i, std::to_string(id) + " RELEASE " + std::to_string(localTimestamp));
-        }
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = "broadcast";
-        logger->log("send", id, std::to_string(id) + " sent release broadcast", note);
+        comm->broadcast(Message(MsgType::RELEASE, id, localTimestamp));
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = "broadcast";
+            return std::to_string(id) + " sent release broadcast";
+        });
     }
 
 private:
     void initialize() override {
+        // moi ban tin o lop NORMAL: Lamport can kenh FIFO giua REQUEST, OK va RELEASE
+        comm->setPriorities(dispatcher.priorities());
         receiveThread = std::thread(&Lamport::receiveMsg, this);
     }
 
     void sendAgree(int dest, int timestamp) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        comm->send(dest, std::to_string(id) + " OK " + std::to_string(timestamp));
-        json note;
-        note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        logger->log("send", id, std::to_string(id) + " sent ok to " + std::to_string(dest), note);
+        comm->send(dest, Message(MsgType::OK, id, timestamp));
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            return std::to_string(id) + " sent ok to " + std::to_string(dest);
+        });
     }
 
     void receivedRqt(int source, int timestamp) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        logger->log("receive", id, std::to_string(id) + " received request from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            return std::to_string(id) + " received request from " + std::to_string(source);
+        });
     
         globalTimestamp = std::max(globalTimestamp, timestamp) + 1;
         REQUEST rqt = {source, timestamp};
@@ -128,12 +140,13 @@ private:
 
     void receivedAgree(int source, int timestamp) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        logger->log("receive", id, std::to_string(id) + " received ok from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            return std::to_string(id) + " received ok from " + std::to_string(source);
+        });
 
         listReply.insert(source);
         cv.notify_one();
@@ -141,39 +154,24 @@ private:
 
     void receivedRls(int source, int timestamp) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        logger->log("receive", id, std::to_string(id) + " received release from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = (listReply.size() == totalNodes - 1) && (listRqt.top().id == id) ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            return std::to_string(id) + " received release from " + std::to_string(source);
+        });
 
         listRqt.pop();
         cv.notify_one();
     }
 
-    void processMsg(const std::string msg) {
-        std::istringstream iss(msg);
-        int id;
-        std::string type;
-        int timestamp;
-        iss >> id >> type >> timestamp;
-        if (type == "REQUEST") {
-            receivedRqt(id, timestamp);
-            sendAgree(id, timestamp);
-        } else if (type == "OK") {
-            receivedAgree(id, timestamp);
-        } else if (type == "RELEASE") {
-            receivedRls(id, timestamp);
-        }
-    }
-
     void receiveMsg() {
-        std::string msg;
-        while (1) {
-            msg = "";
-            if (comm->getMessage(msg)) {
-                processMsg(msg);
+        std::vector<Buffer> messages;
+        while (true) {
+            comm->getMessages(messages, 32);
+            for (auto &message : messages) {
+                dispatcher.dispatch(message.view());
             }
         }
     }
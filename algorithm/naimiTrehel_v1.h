@@ -21,20 +21,27 @@ private:
 
     std::thread receiveThread;
 
+    Dispatcher<NaimiTrehelV1> dispatcher;
+
 public:
     NaimiTrehelV1(int id, const std::string& ip, int port, std::shared_ptr<Comm> comm) 
-        : TokenBasedNode(id, ip, port, comm), last(1), next(-1), freetime(true) {
+        : TokenBasedNode(id, ip, port, comm), last(1), next(-1), freetime(true),
+          dispatcher(*this, {
+              {MsgType::REQUEST, [](NaimiTrehelV1 &self, const Message &m) { self.receivedRequest(m.source); }},
+              {MsgType::TOKEN, [](NaimiTrehelV1 &self, const Message &m) { self.receivedToken(m.source); }, Priority::CONTROL},
+          }) {
         hasToken = (id == 1);
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["init"] = "ok";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " init", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["init"] = "ok";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " init";
+        });
 
         initialize();
     }   
@@ -49,42 +56,49 @@ public:
         std::unique_lock<std::mutex> lock(mtx);
         freetime = false;
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " request token", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " request token";
+        });
 
         if (!hasToken) {
             sendRequest(id, last);
             cv.wait(lock, [this] { return hasToken; });
             {
-                json note;
-                note["status"] = "ok";
-                note["error"] = "null";
-                note["source"] = "null";
-                note["dest"] = "null";
-                note["last"] = last;
-                note["next"] = next;
-                logger->log("notice", id, std::to_string(id) + " enter critical section", note);
+                logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                    note["status"] = "ok";
+                    note["error"] = "null";
+                    note["source"] = "null";
+                    note["dest"] = "null";
+                    note["last"] = last;
+                    note["next"] = next;
+                    return std::to_string(id) + " enter critical section";
+                });
             }     
         }
     }
 
+    DispatchStats getDispatchStats() const override {
+        return dispatcher.getStats();
+    }
+
     void releaseToken() override {
         std::unique_lock<std::mutex> lock(mtx);
         {
-            json note;
-            note["status"] = "ok";
-            note["error"] = "null";
-            note["source"] = "null";
-            note["dest"] = "null";
-            note["last"] = last;
-            note["next"] = next;
-            logger->log("notice", id, std::to_string(id) + " exit critical section", note);
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                note["status"] = "ok";
+                note["error"] = "null";
+                note["source"] = "null";
+                note["dest"] = "null";
+                note["last"] = last;
+                note["next"] = next;
+                return std::to_string(id) + " exit critical section";
+            });
         }    
         freetime = true;
         
@@ -93,33 +107,36 @@ public:
             sendToken(next);
             next = -1;
 
-            json note;
-            note["status"] = "null";
-            note["error"] = "null";
-            note["source"] = "null";
-            note["dest"] = "null";
-            note["last"] = last;
-            note["next"] = "null";
-            logger->log("notice", id, std::to_string(id) + " release", note);
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                note["status"] = "null";
+                note["error"] = "null";
+                note["source"] = "null";
+                note["dest"] = "null";
+                note["last"] = last;
+                note["next"] = "null";
+                return std::to_string(id) + " release";
+            });
         }
     }
 
 private:
     void initialize() override {
+        comm->setPriorities(dispatcher.priorities());
         receiveThread = std::thread(&NaimiTrehelV1::receiveMsg, this);
     }
 
     void receivedRequest(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = source;
-        note["next"] = (next != -1) ? next : (freetime) ? -1 : source;
-        logger->log("receive", id, std::to_string(id) + " received request from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = source;
+            note["next"] = (next != -1) ? next : (freetime) ? -1 : source;
+            return std::to_string(id) + " received request from " + std::to_string(source);
+        });
 
         if (id != last) {
             sendRequest(source, last);
@@ -136,73 +153,60 @@ private:
         std::unique_lock<std::mutex> lock(mtxMsg);
         hasToken = true;
 
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received token", note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received token";
+        });
 
         cv.notify_one();
     }
 
     void sendRequest(int source, int dest) {
-        std::string message = std::to_string(source) + " REQUEST";
+        Message message(MsgType::REQUEST, source);
         last = source;
 
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        if (id == source) {
-            logger->log("send", id, std::to_string(id) + " sent request to " + std::to_string(dest), note);
-        } else {
-            logger->log("send", id, std::to_string(id) + " sent request to " + std::to_string(dest) + " for " + std::to_string(source), note);
-        }
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            std::string content = std::to_string(id) + " sent request to " + std::to_string(dest);
+            return id == source ? content : content + " for " + std::to_string(source);
+        });
         
         comm->send(dest, message);
     }
 
     void sendToken(int dest) {
-        std::string message = std::to_string(id) + " TOKEN";
+        Message message(MsgType::TOKEN, id);
         hasToken = false;
 
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent token to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent token to " + std::to_string(dest);
+        });
 
         comm->send(dest, message);
     }
 
-    void processMessage(const std::string& message) {
-        std::istringstream iss(message);
-        std::string msg;
-        int source;
-        iss >> source >> msg;
-
-        if (msg == "REQUEST") {
-            receivedRequest(source);
-        } else if (msg == "TOKEN") {
-            receivedToken(source);
-        }
-    }
-
     void receiveMsg() {
-        std::string message;
+        std::vector<Buffer> messages;
         while (true) {
-            message = "";
-            if (comm->getMessage(message)) {
-                processMessage(message);
+            comm->getMessages(messages, 32);
+            for (auto &message : messages) {
+                dispatcher.dispatch(message.view());
             }
         }
     }
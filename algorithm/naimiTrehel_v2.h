@@ -31,21 +31,34 @@ private:
     const std::chrono::seconds T_wait{8};
     const std::chrono::seconds T_elec{5};
 
+    Dispatcher<NaimiTrehelV2> dispatcher;
+
 public:
     NaimiTrehelV2(int id, const std::string& ip, int port, std::shared_ptr<Comm> comm) 
-        : TokenBasedNode(id, ip, port, comm), last(1), next(-1), freetime(true) {
+        : TokenBasedNode(id, ip, port, comm), last(1), next(-1), freetime(true),
+          dispatcher(*this, {
+              {MsgType::REQUEST, [](NaimiTrehelV2 &self, const Message &m) { self.receiveRequest(m.source); }},
+              {MsgType::TOKEN, [](NaimiTrehelV2 &self, const Message &m) { self.receiveToken(m.source); }, Priority::CONTROL},
+              {MsgType::CONSULT, [](NaimiTrehelV2 &self, const Message &m) { self.receiveConsult(m.source); }, Priority::BULK},
+              {MsgType::ACK_CONSULT, [](NaimiTrehelV2 &self, const Message &m) { self.receiveAckConsult(m.source); }, Priority::BULK},
+              {MsgType::FAILURE, [](NaimiTrehelV2 &self, const Message &m) { self.receiveFailure(m.source); }, Priority::BULK},
+              {MsgType::ACK_FAILURE, [](NaimiTrehelV2 &self, const Message &m) { self.receiveAckFailure(m.source); }, Priority::BULK},
+              {MsgType::ELECTION, [](NaimiTrehelV2 &self, const Message &m) { self.receiveElection(m.source); }, Priority::BULK},
+              {MsgType::ELECTED, [](NaimiTrehelV2 &self, const Message &m) { self.receiveElected(m.source); }, Priority::BULK},
+          }) {
         hasToken = (id == 1);
         totalNodes = config.getTotalNodes();
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["init"] = "ok";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " init", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["init"] = "ok";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " init";
+        });
 
         initialize();
     }   
@@ -60,14 +73,15 @@ public:
         std::unique_lock<std::mutex> lock(mtx);
         freetime = false;
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " request token", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " request token";
+        });
 
         if (!hasToken) {
             sendRequest(id, last);
@@ -78,14 +92,15 @@ public:
                     sendRequest(id, last);
                 } else {
                     if (!cv.wait_for(lock, std::chrono::seconds(T_wait), [this]() { return hasToken; })) {
-                        json note;
-                        note["status"] = "null";
-                        note["error"] = "suspect";
-                        note["source"] = "null";
-                        note["dest"] = "null";
-                        note["last"] = last;
-                        note["next"] = next;
-                        logger->log("notice", id, std::to_string(id) + " suspect that a failure occurred", note);
+                        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                            note["status"] = "null";
+                            note["error"] = "suspect";
+                            note["source"] = "null";
+                            note["dest"] = "null";
+                            note["last"] = last;
+                            note["next"] = next;
+                            return std::to_string(id) + " suspect that a failure occurred";
+                        });
 
                         lock.unlock();
                         sendConsult();
@@ -96,6 +111,10 @@ public:
         }
     }
 
+    DispatchStats getDispatchStats() const override {
+        return dispatcher.getStats();
+    }
+
     void releaseToken() override {
         std::unique_lock<std::mutex> lock(mtx); 
         freetime = false;
@@ -104,39 +123,47 @@ public:
             sendToken(next);
             next = -1;
 
-            json note;
-            note["status"] = "null";
-            note["error"] = "null";
-            note["source"] = "null";
-            note["dest"] = "null";
-            note["last"] = last;
-            note["next"] = -1;
-            logger->log("notice", id, std::to_string(id) + " release", note);
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                note["status"] = "null";
+                note["error"] = "null";
+                note["source"] = "null";
+                note["dest"] = "null";
+                note["last"] = last;
+                note["next"] = -1;
+                return std::to_string(id) + " release";
+            });
         }
     }
 
 private:
     void initialize() override {
+        comm->setPriorities(dispatcher.priorities());
         receiveThread = std::thread(&NaimiTrehelV2::receiveMsg, this);
+        // che do RELIABLE: biet ngay peer khong lien lac duoc thay vi doi timeout cua giao thuc
+        comm->onDeliveryFailure([this](int peerId, size_t count) {
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                note["error"] = "unreachable";
+                note["dest"] = peerId;
+                note["lost"] = count;
+                return std::to_string(id) + " cannot reach " + std::to_string(peerId);
+            });
+        });
     }
 
     void sendRequest(int source, int dest) {
-        std::string message = std::to_string(source) + " REQUEST";
+        Message message(MsgType::REQUEST, source);
         last = source;
 
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-
-        if (id == source) {
-            logger->log("send", id, std::to_string(id) + " sent request to " + std::to_string(dest), note);
-        } else {
-            logger->log("send", id, std::to_string(id) + " sent request to " + std::to_string(dest) + " for " + std::to_string(source), note);
-        }
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            std::string content = std::to_string(id) + " sent request to " + std::to_string(dest);
+            return id == source ? content : content + " for " + std::to_string(source);
+        });
 
         comm->send(dest, message);
     }
@@ -144,14 +171,15 @@ private:
     void receiveRequest(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = source;
-        note["next"] = (next != -1) ? next : (freetime) ? -1 : source;
-        logger->log("receive", id, std::to_string(id) + " received request from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = source;
+            note["next"] = (next != -1) ? next : (freetime) ? -1 : source;
+            return std::to_string(id) + " received request from " + std::to_string(source);
+        });
 
         if (id != last) {
             sendRequest(source, last);
@@ -165,17 +193,18 @@ private:
     }
 
     void sendToken(int dest) {
-        std::string message = std::to_string(id) + " TOKEN";
+        Message message(MsgType::TOKEN, id);
         hasToken = false;
         
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent token to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent token to " + std::to_string(dest);
+        });
         
         comm->send(dest, message);
     }
@@ -184,14 +213,15 @@ private:
         std::unique_lock<std::mutex> lock(mtxMsg);
         hasToken = true;
 
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received token from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received token from " + std::to_string(source);
+        });
 
         cv.notify_one();
     }
@@ -201,20 +231,17 @@ private:
             std::unique_lock<std::mutex> lock(mtx);
             hasAckConsult = false;
 
-            json note;
-            note["status"] = "null";
-            note["error"] = "null";
-            note["source"] = id;
-            note["dest"] = "broadcast";
-            note["last"] = last;
-            note["next"] = next;
-            logger->log("send", id, std::to_string(id) + " broadcast consult message", note);
+            logger->log(LogCategory::SEND, id, [&](json &note) {
+                note["status"] = "null";
+                note["error"] = "null";
+                note["source"] = id;
+                note["dest"] = "broadcast";
+                note["last"] = last;
+                note["next"] = next;
+                return std::to_string(id) + " broadcast consult message";
+            });
 
-            for (int i = 1; i <= totalNodes; i++) {
-                if (i != id) {
-                    comm->send(i, std::to_string(id) + " CONSULT");
-                }
-            }
+            comm->broadcast(Message(MsgType::CONSULT, id));
 
             if (cv.wait_for(lock, T_elec, [this]() { return hasAckConsult || hasToken || voted; })) {
                 return; 
@@ -226,14 +253,15 @@ private:
     void receiveConsult(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received consult message from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received consult message from " + std::to_string(source);
+        });
 
         if (next == source) {
             sendAckConsult(source);
@@ -241,30 +269,32 @@ private:
     }
 
     void sendAckConsult(int dest) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent ack consult message to " + std::to_string(dest), note);
-
-        comm->send(dest, std::to_string(id) + " ACK_CONSULT");
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent ack consult message to " + std::to_string(dest);
+        });
+
+        comm->send(dest, Message(MsgType::ACK_CONSULT, id));
     }
 
     void receiveAckConsult(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
         hasAckConsult = true;
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received ack consult message from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received ack consult message from " + std::to_string(source);
+        });
 
         cv.notify_one();
     }
@@ -274,20 +304,17 @@ private:
             std::unique_lock<std::mutex> lock(mtx);
             hasAckFailure = false;
 
-            json note;
-            note["status"] = "null";
-            note["error"] = "null";
-            note["source"] = id;
-            note["dest"] = "broadcast";
-            note["last"] = last;
-            note["next"] = next;
-            logger->log("send", id, std::to_string(id) + " broadcast failure message", note);
+            logger->log(LogCategory::SEND, id, [&](json &note) {
+                note["status"] = "null";
+                note["error"] = "null";
+                note["source"] = id;
+                note["dest"] = "broadcast";
+                note["last"] = last;
+                note["next"] = next;
+                return std::to_string(id) + " broadcast failure message";
+            });
 
-            for (int i = 1; i <= totalNodes; i++) {
-                if (i != id) {
-                    comm->send(i, std::to_string(id) + " FAILURE");
-                }
-            }
+            comm->broadcast(Message(MsgType::FAILURE, id));
 
             if (cv.wait_for(lock, T_elec, [this]() { return hasAckFailure || hasToken || voted; })) {
                 return; 
@@ -299,14 +326,15 @@ private:
     void receiveFailure(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received failure message from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received failure message from " + std::to_string(source);
+        });
 
         if (hasToken) {
             sendAckFailure(source);
@@ -314,30 +342,32 @@ private:
     }
 
     void sendAckFailure(int dest) {
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent ack failure message to " + std::to_string(dest), note);
-
-        comm->send(dest, std::to_string(id) + " ACK_FAILURE");       
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent ack failure message to " + std::to_string(dest);
+        });
+
+        comm->send(dest, Message(MsgType::ACK_FAILURE, id));       
     }
 
     void receiveAckFailure(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
         hasAckFailure = true;
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received ack failure message from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received ack failure message from " + std::to_string(source);
+        });
 
         cv.notify_one();
     }
@@ -348,20 +378,17 @@ private:
             listCandidate.clear();
             listCandidate[id] = true;
 
-            json note;
-            note["status"] = "null";
-            note["error"] = "null";
-            note["source"] = id;
-            note["dest"] = "broadcast";
-            note["last"] = last;
-            note["next"] = next;
-            logger->log("send", id, std::to_string(id) + " broadcast election message", note);
-
-            for (int i = 1; i <= totalNodes; i++) {
-                if (i != id) {
-                    comm->send(i, std::to_string(id) + " ELECTION");
-                }
-            }
+            logger->log(LogCategory::SEND, id, [&](json &note) {
+                note["status"] = "null";
+                note["error"] = "null";
+                note["source"] = id;
+                note["dest"] = "broadcast";
+                note["last"] = last;
+                note["next"] = next;
+                return std::to_string(id) + " broadcast election message";
+            });
+
+            comm->broadcast(Message(MsgType::ELECTION, id));
             
             if (cv.wait_for(lock, T_elec, [this]() { return hasToken || voted; })) {
                 return;
@@ -372,14 +399,15 @@ private:
 
     void receiveElection(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received eletion message from " + std::to_string(source), note);     
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received eletion message from " + std::to_string(source);
+        });
 
         listCandidate[source] = true;
     }
@@ -391,41 +419,45 @@ private:
             if (it.first < minCandidate) minCandidate = it.first;
         }
         if (id == minCandidate) {
-            json note;
-            note["status"] = "ok";
-            note["error"] = "null";
-            note["source"] = "null";
-            note["dest"] = "null";
-            note["last"] = id;
-            note["next"] = -1;
-            logger->log("notice", id, std::to_string(id) + " regenerated token", note);
+            auto fill = [this](json &note) {
+                note["status"] = "ok";
+                note["error"] = "null";
+                note["source"] = "null";
+                note["dest"] = "null";
+                note["last"] = id;
+                note["next"] = -1;
+            };
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                fill(note);
+                return std::to_string(id) + " regenerated token";
+            });
 
             hasToken = true;
             last = id;
             next = -1;
             // listCandidate.clear();
 
-            note["source"] = id;
-            note["dest"] = "broadcast";
-            logger->log("send", id, std::to_string(id) + " broadcast elected message", note);
-            for (int i = 1; i <= totalNodes; i++) {
-                if (i != id) {
-                    comm->send(i, std::to_string(id) + " ELECTED");
-                }
-            }
+            logger->log(LogCategory::SEND, id, [&](json &note) {
+                fill(note);
+                note["source"] = id;
+                note["dest"] = "broadcast";
+                return std::to_string(id) + " broadcast elected message";
+            });
+            comm->broadcast(Message(MsgType::ELECTED, id));
         }
     }
 
     void receiveElected(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received eleted message from " + std::to_string(source), note);        
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received eleted message from " + std::to_string(source);
+        });
 
         next = -1;
         last = source;
@@ -437,37 +469,12 @@ private:
         cv.notify_one();
     }
 
-    void processMessage(const std::string& message) {
-        std::istringstream iss(message);
-        std::string msgType;
-        int source;
-        iss >> source >> msgType;
-
-        if (msgType == "REQUEST") {
-            receiveRequest(source);
-        } else if (msgType == "TOKEN") {
-            receiveToken(source);
-        } else if (msgType == "CONSULT") {
-            receiveConsult(source);
-        } else if (msgType == "ACK_CONSULT") { 
-            receiveAckConsult(source);
-        } else if (msgType == "FAILURE") { 
-            receiveFailure(source);
-        } else if (msgType == "ACK_FAILURE") {
-            receiveAckFailure(source);
-        } else if (msgType == "ELECTION") {
-            receiveElection(source);
-        } else if (msgType == "ELECTED") {
-            receiveElected(source);
-        }
-    }
-
     void receiveMsg() {
-        std::string message;
+        std::vector<Buffer> messages;
         while (true) {
-            message = "";
-            if (comm->getMessage(message)) {
-                processMessage(message);
+            comm->getMessages(messages, 32);
+            for (auto &message : messages) {
+                dispatcher.dispatch(message.view());
             }
         }
     }
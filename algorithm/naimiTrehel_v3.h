@@ -44,9 +44,40 @@ private:
     const std::chrono::milliseconds T_msg{500};
     const std::chrono::seconds T_ping{5};
 
+    Dispatcher<NaimiTrehelV3> dispatcher;
+
 public:
     NaimiTrehelV3(int id, const std::string& ip, int port, int k, std::shared_ptr<Comm> comm) 
-        : TokenBasedNode(id, ip, port, comm), k(k), last(1), next(-1), predecessor(-1), cnt(0), freetime(true) {
+        : TokenBasedNode(id, ip, port, comm), k(k), last(1), next(-1), predecessor(-1), cnt(0), freetime(true),
+          dispatcher(*this, {
+              {MsgType::REQUEST, [](NaimiTrehelV3 &self, const Message &m) { self.receivedRequest(m.source); }},
+              {MsgType::COMMIT, [](NaimiTrehelV3 &self, const Message &m) {
+                  std::vector<int> predes(self.k);
+                  for (int i = 0; i < self.k; i++) {
+                      predes[i] = m.value(i);
+                  }
+                  self.receivedCommit(m.source, predes, m.value(self.k));
+              }, Priority::CONTROL},
+              {MsgType::TOKEN, [](NaimiTrehelV3 &self, const Message &) { self.receivedToken(); }, Priority::CONTROL},
+              {MsgType::ARE_YOU_ALIVE, [](NaimiTrehelV3 &self, const Message &m) { self.receiveAreYouAlive(m.source); }, Priority::CONTROL},
+              {MsgType::I_AM_ALIVE, [](NaimiTrehelV3 &self, const Message &m) { self.receiveIAmAlive(m.source); }, Priority::CONTROL},
+              {MsgType::REQUEST_M1, [](NaimiTrehelV3 &self, const Message &m) { self.receiveRequestM1(m.source); }},
+              {MsgType::SEARCH_PREV, [](NaimiTrehelV3 &self, const Message &m) { self.receiveSearchPrev(m.source, m.value(0)); }, Priority::BULK},
+              {MsgType::ACK_SEARCH_PREV, [](NaimiTrehelV3 &self, const Message &m) { self.receiveAckSearchPrev(m.source, m.value(0)); }, Priority::BULK},
+              {MsgType::SEARCH_QUEUE, [](NaimiTrehelV3 &self, const Message &m) {
+                  self.otherId = m.source;
+                  self.otherCnt = m.value(0);
+                  self.receiveSearchQueue(m.source);
+              }, Priority::BULK},
+              {MsgType::ACK_SEARCH_QUEUE, [](NaimiTrehelV3 &self, const Message &m) { self.receivedAckSearchQueue(m.source, m.value(0), m.value(1)); }, Priority::BULK},
+              {MsgType::CONNECTION, [](NaimiTrehelV3 &self, const Message &m) { self.receivedConnection(m.source); }, Priority::BULK},
+              {MsgType::REGENERATED, [](NaimiTrehelV3 &self, const Message &m) { self.receiveRegenerated(m.source); }, Priority::BULK},
+              {MsgType::PING, [](NaimiTrehelV3 &self, const Message &m) { self.receivePing(m.source); }, Priority::CONTROL},
+              {MsgType::PONG, [](NaimiTrehelV3 &self, const Message &m) { self.receivePong(m.source); }, Priority::CONTROL},
+          }) {
+        if (k < 1) {
+            throw std::runtime_error("k must be at least 1\n");
+        }
         totalNodes = config.getTotalNodes();
         hasToken = (id == 1);
         position = (id == 1 ? 0 : -1);
@@ -54,15 +85,16 @@ public:
             listPredecesers.push_back(-1);
         }
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["init"] = "ok";
-        // note["error"] = "null";
-        // note["source"] = "null";
-        // note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " init", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["init"] = "ok";
+            // note["error"] = "null";
+            // note["source"] = "null";
+            // note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " init";
+        });
 
         initialize();
     }   
@@ -80,14 +112,15 @@ public:
         std::unique_lock<std::mutex> lock(mtx);
         freetime = false;
         
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " request token", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " request token";
+        });
         
         if (!hasToken) {
             sendRequest(id, last);
@@ -101,6 +134,10 @@ public:
         
     }   
 
+    DispatchStats getDispatchStats() const override {
+        return dispatcher.getStats();
+    }
+
     void releaseToken() override {
         std::unique_lock<std::mutex> lock(mtx);
         cnt++;
@@ -114,54 +151,63 @@ public:
             sendToken(next);
             next = -1;
 
-            json note;
-            note["status"] = "null";
-            note["error"] = "null";
-            note["source"] = "null";
-            note["dest"] = "null";
-            note["last"] = last;
-            note["next"] = -1;
-            logger->log("notice", id, std::to_string(id) + " release", note);
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                note["status"] = "null";
+                note["error"] = "null";
+                note["source"] = "null";
+                note["dest"] = "null";
+                note["last"] = last;
+                note["next"] = -1;
+                return std::to_string(id) + " release";
+            });
         }
     }
 
 private:
     void initialize() override {
+        comm->setPriorities(dispatcher.priorities());
         receiveThread = std::thread(&NaimiTrehelV3::receiveMsg, this);
+        // che do RELIABLE: biet ngay peer khong lien lac duoc thay vi doi timeout cua giao thuc
+        comm->onDeliveryFailure([this](int peerId, size_t count) {
+            logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                note["error"] = "unreachable";
+                note["dest"] = peerId;
+                note["lost"] = count;
+                return std::to_string(id) + " cannot reach " + std::to_string(peerId);
+            });
+        });
         pingPong = std::thread(&NaimiTrehelV3::sendPing, this);
     }
 
     void sendRequest(int source, int dest) {
-        std::string message = std::to_string(source) + " REQUEST";
+        Message message(MsgType::REQUEST, source);
         last = source;
 
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        
-        if (id == source) {
-            logger->log("send", id, std::to_string(id) + " sent request to " + std::to_string(dest), note);
-        } else {
-            logger->log("send", id, std::to_string(id) + " sent request to " + std::to_string(dest) + " for " + std::to_string(source), note);
-        }
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            std::string content = std::to_string(id) + " sent request to " + std::to_string(dest);
+            return id == source ? content : content + " for " + std::to_string(source);
+        });
         
         comm->send(dest, message);
     }
 
     void receivedRequest(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = source;
-        note["next"] = (next != -1) ? next : (freetime) ? -1 : source;
-        logger->log("receive", id, std::to_string(id) + " received request from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = source;
+            note["next"] = (next != -1) ? next : (freetime) ? -1 : source;
+            return std::to_string(id) + " received request from " + std::to_string(source);
+        });
         
         if (id != last) {
             sendRequest(source, last);
@@ -174,35 +220,32 @@ private:
     }
 
     void sendCommit(int dest) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = dest;
-        note["next"] = dest;
-        logger->log("send", id, std::to_string(id) + " sent commit to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = dest;
+            note["next"] = dest;
+            return std::to_string(id) + " sent commit to " + std::to_string(dest);
+        });
         
         next = dest;
         last = dest;
-        std::string msg = std::to_string(id) + " COMMIT ";
-        for (int i = 1; i < k; i++) {
-            msg += " " + std::to_string(listPredecesers[i]);
-        }
-        msg += " " + std::to_string(id) + " " + std::to_string(position + 1);
-        comm->send(dest, msg);
+        comm->send(dest, commitMessage());
     }
 
     void receivedCommit(int source, std::vector<int> predes, int pos) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received commit message from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received commit message from " + std::to_string(source);
+        });
 
         predecessor = source;
         this->listPredecesers = predes;
@@ -212,29 +255,31 @@ private:
     }
 
     void sendToken(int destId) {
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = next;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent token to " + std::to_string(next), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = next;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent token to " + std::to_string(next);
+        });
 
         hasToken = false;
-        std::string message = std::to_string(id) + " TOKEN";
+        Message message(MsgType::TOKEN, id);
         comm->send(destId, message);
     }
 
     void receivedToken() {
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = predecessor;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received token from " + std::to_string(predecessor), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = predecessor;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received token from " + std::to_string(predecessor);
+        });
 
         hasToken = true;
         cv.notify_one();
@@ -242,14 +287,15 @@ private:
 
     void mechanism1() { 
         std::unique_lock<std::mutex> lock(mtxPingPong);
-        json note;
-        note["status"] = "null";
-        note["error"] = predecessor;
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " detected " + std::to_string(predecessor) + " failure", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = predecessor;
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " detected " + std::to_string(predecessor) + " failure";
+        });
 
         predecessor = -1;
         for (int i = k - 2; i >= 0; i--) {
@@ -271,95 +317,96 @@ private:
     }
 
     void sendAreYouAlive(int dest) {
-        comm->send(dest, std::to_string(id) + " ARE_YOU_ALIVE");
+        comm->send(dest, Message(MsgType::ARE_YOU_ALIVE, id));
     }
 
     void receiveAreYouAlive(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received are you alive from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received are you alive from " + std::to_string(source);
+        });
         
         sendIAmAlive(source);
     }
 
     void sendIAmAlive(int dest) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent i am alive to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent i am alive to " + std::to_string(dest);
+        });
 
-        comm->send(dest, std::to_string(id) + " I_AM_ALIVE");
+        comm->send(dest, Message(MsgType::I_AM_ALIVE, id));
     }
     
     void receiveIAmAlive(int source) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received i am alive from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received i am alive from " + std::to_string(source);
+        });
         
         hasAlive = true;
         cv.notify_one();
     }
 
     void sendRequestM1(int dest) { 
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent request m1 to " + std::to_string(dest), note);
-
-        std::string message = std::to_string(id) + " REQUEST_M1";
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent request m1 to " + std::to_string(dest);
+        });
+
+        Message message(MsgType::REQUEST_M1, id);
         comm->send(dest, message);
     }
 
     void receiveRequestM1(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = source;
-        logger->log("receive", id, std::to_string(id) + " received request m1 from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = source;
+            return std::to_string(id) + " received request m1 from " + std::to_string(source);
+        });
 
         sendCommitM1(source);
     }
 
     void sendCommitM1(int dest) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = dest;
-        logger->log("send", id, std::to_string(id) + " sent commit m1 to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = dest;
+            return std::to_string(id) + " sent commit m1 to " + std::to_string(dest);
+        });
 
         next = dest;
-        std::string msg = std::to_string(id) + " COMMIT ";
-        for (int i = 1; i < k; i++) {
-            msg += " " + std::to_string(listPredecesers[i]);
-        }
-        msg += " " + std::to_string(id) + " " + std::to_string(position + 1);
-        comm->send(dest, msg);
+        comm->send(dest, commitMessage());
     }
 
     void mechanism2() {
@@ -372,14 +419,15 @@ private:
                 listFailure += std::to_string(listPredecesers[i]);
             }
         }
-        json note;
-        note["status"] = "null";
-        note["error"] = listFailure;
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " detected " + listFailure + " failure", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = listFailure;
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " detected " + listFailure + " failure";
+        });
 
         aliveM2.clear();
         sendSearchPrev();
@@ -401,32 +449,32 @@ private:
     }
 
     void sendSearchPrev() {
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = "broadcast";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " broadcast search prev", note);
-
-        for (int i = 1; i <= totalNodes; i++) {
-            if (i != id) {
-                comm->send(i, std::to_string(id) + " SEARCH_PREV " +  std::to_string(position));
-            }
-        }
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = "broadcast";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " broadcast search prev";
+        });
+
+        Message message(MsgType::SEARCH_PREV, id);
+        message.push(position);
+        comm->broadcast(message);
     }
 
     void receiveSearchPrev(int source, int pos) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received search prev from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received search prev from " + std::to_string(source);
+        });
 
         if (position < pos) {
             sendAckSearchPrev(source);
@@ -434,33 +482,41 @@ private:
     }
 
     void sendAckSearchPrev(int dest) {
-        comm->send(dest, std::to_string(id) + " ACK_SEARCH_PREV" + std::to_string(position));
+        Message message(MsgType::ACK_SEARCH_PREV, id);
+        message.push(position);
+        comm->send(dest, message);
     }
 
     void receiveAckSearchPrev(int source, int pos) {
         std::unique_lock<std::mutex> lock(mtxMsg);
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received ack search prev from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received ack search prev from " + std::to_string(source);
+        });
 
         aliveM2.insert(std::pair<int, int>{source, pos});
     }
 
     void mechanism3() { 
         std::unique_lock<std::mutex> lock(mtx);
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " sent request message but didn't receive commit", note);
+        // cac ban ghi cua co che 3 giu last / next luc bat dau
+        auto fill = [last = last, next = next](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+        };
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            fill(note);
+            return std::to_string(id) + " sent request message but didn't receive commit";
+        });
 
         bool stop = false;
         failureDetected = true;
@@ -502,16 +558,25 @@ private:
                 if (cv.wait_for(lock, 2 * T_msg, [this]() { return hasCommit; })) {
                     return;
                 } else {
-                    logger->log("notice", id, std::to_string(id) + " detected " + std::to_string(maxElement.first) + " failure", note);
+                    logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                        fill(note);
+                        return std::to_string(id) + " detected " + std::to_string(maxElement.first) + " failure";
+                    });
                 }
             } else {
-                logger->log("notice", id, std::to_string(id) + " detected " + std::to_string(maxElement.second.second) + " failure", note);
+                logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                    fill(note);
+                    return std::to_string(id) + " detected " + std::to_string(maxElement.second.second) + " failure";
+                });
 
                 sendConnection(maxElement.first);       
                 if (cv.wait_for(lock, 2 * T_msg, [this]() { return hasCommit; })) {
                     return;
                 } else {
-                    logger->log("notice", id, std::to_string(id) + " detected " + std::to_string(maxElement.first) + " failure", note);
+                    logger->log(LogCategory::NOTICE, id, [&](json &note) {
+                        fill(note);
+                        return std::to_string(id) + " detected " + std::to_string(maxElement.first) + " failure";
+                    });
                 }
             } 
         }
@@ -521,31 +586,31 @@ private:
     }
 
     void sendSearchQueue() {
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = "broadcast";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " broadcast search queue", note);
-
-        for (int i = 1; i <= totalNodes; i++) {
-            if (i != id) {
-                comm->send(i, std::to_string(id) + " SEARCH_QUEUE " + std::to_string(cnt));
-            }
-        }
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = "broadcast";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " broadcast search queue";
+        });
+
+        Message message(MsgType::SEARCH_QUEUE, id);
+        message.push(cnt);
+        comm->broadcast(message);
     }
 
     void receiveSearchQueue(int source) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received search queue from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received search queue from " + std::to_string(source);
+        });
 
         if (!failureDetected) {
             if (position != -1) {
@@ -557,85 +622,99 @@ private:
     }
 
     void sendAckSearchQueue(int dest) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent ack search queue to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent ack search queue to " + std::to_string(dest);
+        });
 
-        comm->send(dest, std::to_string(id) + " ACK_SEARCH_QUEUE " + std::to_string(position) + " " + std::to_string(next));
+        Message message(MsgType::ACK_SEARCH_QUEUE, id);
+        message.push(position);
+        message.push(next);
+        comm->send(dest, message);
     }
 
     void receivedAckSearchQueue(int source, int pos, int next) {
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = this->next;
-        logger->log("received", id, std::to_string(id) + " received ack search queue from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = this->next;
+            return std::to_string(id) + " received ack search queue from " + std::to_string(source);
+        });
 
         aliveM3.insert(std::pair(source, std::pair(pos, next)));
     }   
 
     void sendConnection(int dest) {
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " sent connection to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " sent connection to " + std::to_string(dest);
+        });
 
-        comm->send(dest, std::to_string(id) + " CONNECTION");
+        comm->send(dest, Message(MsgType::CONNECTION, id));
     }
 
     void receivedConnection(int source) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = source;
-        logger->log("receive", id, std::to_string(id) + " received connection from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = source;
+            return std::to_string(id) + " received connection from " + std::to_string(source);
+        });
 
         sendAckConnection(source);
     }
 
     void sendAckConnection(int dest) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = dest;
-        note["last"] = last;
-        note["next"] = dest;
-        logger->log("send", id, std::to_string(id) + " sent token to " + std::to_string(dest), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = dest;
+            note["last"] = last;
+            note["next"] = dest;
+            return std::to_string(id) + " sent token to " + std::to_string(dest);
+        });
 
         next = dest;
-        std::string msg = std::to_string(id) + " COMMIT ";
-        for (int i = 1; i < k; i++) {
-            msg += " " + std::to_string(listPredecesers[i]);
-        }
-        msg += " " + std::to_string(id) + " " + std::to_string(position + 1);
-        comm->send(dest, msg);
+        comm->send(dest, commitMessage());
+    }
+
+    // COMMIT: k-1 nut tien nhiem cua node nay va chinh node nay, roi vi tri cua nut nhan.
+    // Cac nut tien nhiem duoc tham chieu thang tu listPredecesers, ban tin phai gui ngay
+    Message commitMessage() const {
+        Message message(MsgType::COMMIT, id);
+        message.list(listPredecesers.data() + 1, k - 1);
+        message.push(id);
+        message.push(position + 1);
+        return message;
     }
 
     void regeneratedToken() {
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("notice", id, std::to_string(id) + " regenerated token", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " regenerated token";
+        });
 
         hasToken = true;
         position = 0;
@@ -644,20 +723,17 @@ private:
     }
 
     void sendRegenerated() {
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = "broadcast";
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("send", id, std::to_string(id) + " broadcast regenerated", note);
-
-        for (int i = 1; i <= totalNodes; i++) {
-            if (i != id) {
-                comm->send(i, std::to_string(id) + " REGENERATED");
-            }
-        }
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = "broadcast";
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " broadcast regenerated";
+        });
+
+        comm->broadcast(Message(MsgType::REGENERATED, id));
     }
 
     void receiveRegenerated(int source) {
@@ -669,14 +745,15 @@ private:
             next = last;
         }
 
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        note["last"] = last;
-        note["next"] = next;
-        logger->log("receive", id, std::to_string(id) + " received regenerated from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            note["last"] = last;
+            note["next"] = next;
+            return std::to_string(id) + " received regenerated from " + std::to_string(source);
+        });
     }
 
     void sendPing() {
@@ -685,7 +762,7 @@ private:
             if (hasToken || predecessor == -1) {
                 continue;
             }
-            comm->send(predecessor, std::to_string(id) + " PING");
+            comm->send(predecessor, Message(MsgType::PING, id));
             if (!cv.wait_for(lock, 2 * T_msg, [this]() { return hasPong; })) {
                 lock.unlock();
                 mechanism1();
@@ -701,7 +778,7 @@ private:
     }
 
     void sendPong(int dest) {
-        comm->send(dest, std::to_string(id) + " PONG");
+        comm->send(dest, Message(MsgType::PONG, id));
     }
 
     void receivePong(int source) {
@@ -710,63 +787,12 @@ private:
         cv.notify_one();
     }
 
-    void processMessage(const std::string& message) {
-        std::istringstream iss(message);
-        std::string msgType;
-        int source;
-        iss >> source >> msgType;
-
-        if (msgType == "REQUEST") {
-            receivedRequest(source);
-        } else if (msgType == "COMMIT") {
-            std::vector<int> listPredecesers(k);
-            int pos;
-            for (int i = 0; i < k; i++) {
-                iss >> listPredecesers[i];
-            }
-            iss >> pos;
-            receivedCommit(source, listPredecesers, pos);
-        } else if (msgType == "TOKEN") {
-            receivedToken();
-        } else if (msgType == "ARE_YOU_ALIVE") {
-            receiveAreYouAlive(source);
-        } else if (msgType == "I_AM_ALIVE") {
-            receiveIAmAlive(source);
-        } else if (msgType == "REQUEST_M1") {
-            receiveRequestM1(source);
-        } else if (msgType == "SEARCH_PREV") {
-            int pos;
-            iss >> pos;
-            receiveSearchPrev(source, pos);
-        } else if (msgType == "ACK_SEARCH_PREV") {
-            int pos;
-            iss >> pos;
-            receiveAckSearchPrev(source, pos);
-        } else if (msgType == "SEARCH_QUEUE") {
-            otherId = source;
-            iss >> otherCnt;
-            receiveSearchQueue(source);
-        } else if (msgType == "ACK_SEARCH_QUEUE") {
-            int pos;
-            int next;
-            iss >> pos >> next;
-            receivedAckSearchQueue(source, pos, next);
-        } else if (msgType == "CONNECTION") {
-            receivedConnection(source);
-        } else if (msgType == "REGENERATED") {
-            receiveRegenerated(source);
-        } else if (msgType == "PING") {
-            receivePing(source);
-        } else if (msgType == "PONG") {
-            receivePong(source);
-        } 
-    }
-
     void receiveMsg() {
+        std::vector<Buffer> messages;
         while (true) {
-            std::string message;
-            if (comm->getMessage(message)) {
-                processMessage(message);
+            comm->getMessages(messages, 32);
+            for (auto &message : messages) {
+                dispatcher.dispatch(message.view());
             }
         }
     }
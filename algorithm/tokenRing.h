@@ -25,15 +25,22 @@ private:
 
     std::thread receiveThread;
 
+    Dispatcher<TokenRing> dispatcher;
+
 public:
-    TokenRing(int id, const std::string& ip, int port, std::shared_ptr<Comm> comm) : TokenBasedNode(id, ip, port, comm), needToken(false) {
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["init"] = "ok";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        logger->log("notice", id, std::to_string(id) + " init", note);
+    TokenRing(int id, const std::string& ip, int port, std::shared_ptr<Comm> comm) 
+        : TokenBasedNode(id, ip, port, comm), needToken(false),
+          dispatcher(*this, {
+              {MsgType::TOKEN, [](TokenRing &self, const Message &m) { self.receivedToken(m.source); }, Priority::CONTROL},
+          }) {
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["init"] = "ok";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            return std::to_string(id) + " init";
+        });
         initialize();  
     }
 
@@ -47,31 +54,38 @@ public:
         std::unique_lock<std::mutex> lock(mtx);
         needToken = true;
 
-        json note;
-        note["status"] = hasToken ? "ok" : "null";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        logger->log("notice", id, std::to_string(id) + " request token", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = hasToken ? "ok" : "null";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            return std::to_string(id) + " request token";
+        });
 
         cv.wait(lock, [this] { return hasToken; });
     }
 
+    DispatchStats getDispatchStats() const override {
+        return dispatcher.getStats();
+    }
+
     void releaseToken() override {
         std::unique_lock<std::mutex> lock(mtx);
         needToken = false;
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = "null";
-        note["dest"] = "null";
-        logger->log("notice", id, std::to_string(id) + " release token", note);
+        logger->log(LogCategory::NOTICE, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = "null";
+            note["dest"] = "null";
+            return std::to_string(id) + " release token";
+        });
 
         sendToken();
     }
 
 private:
     void initialize() override {
+        comm->setPriorities(dispatcher.priorities());
         totalNodes = config.getTotalNodes();
         next = id % totalNodes + 1;
         hasToken = (id == 1) ? true : false;
@@ -83,25 +97,27 @@ private:
         std::unique_lock<std::mutex> lock(mtxMsg);
         hasToken = false;
 
-        json note;
-        note["status"] = "null";
-        note["error"] = "null";
-        note["source"] = id;
-        note["dest"] = next;
-        logger->log("send", id, std::to_string(id) + " send token to " + std::to_string(next), note);
+        logger->log(LogCategory::SEND, id, [&](json &note) {
+            note["status"] = "null";
+            note["error"] = "null";
+            note["source"] = id;
+            note["dest"] = next;
+            return std::to_string(id) + " send token to " + std::to_string(next);
+        });
 
-        comm->send(next, std::to_string(id) + " TOKEN");
+        comm->send(next, Message(MsgType::TOKEN, id));
     }
 
     void receivedToken(int source) {
         std::unique_lock<std::mutex> lock(mtxMsg);
         
-        json note;
-        note["status"] = "ok";
-        note["error"] = "null";
-        note["source"] = source;
-        note["dest"] = id;
-        logger->log("recieve", id, std::to_string(id) + " received token from " + std::to_string(source), note);
+        logger->log(LogCategory::RECEIVE, id, [&](json &note) {
+            note["status"] = "ok";
+            note["error"] = "null";
+            note["source"] = source;
+            note["dest"] = id;
+            return std::to_string(id) + " received token from " + std::to_string(source);
+        });
 
         hasToken = true;
         if (needToken) {
@@ -111,21 +127,12 @@ private:
         }
     }
 
-    void processMsg(const std::string &msg) {
-        std::istringstream iss(msg);
-        int id;
-        std::string content;
-        iss >> id >> content;
-        if (content == "TOKEN") {
-            receivedToken(id);
-        }
-    }
-
     void receiveMsg() {
-        std::string msg;
+        std::vector<Buffer> messages;
         while (true) {
-            if (comm->getMessage(msg)) {
-                processMsg(msg);
+            comm->getMessages(messages, 32);
+            for (auto &message : messages) {
+                dispatcher.dispatch(message.view());
             }
         }
     }
@@ -0,0 +1,93 @@
+// chay tat ca TOTAL_NODES node trong mot tien trinh, nen dung voi TRANSPORT=shm
+// g++ application/cluster.cpp -o application/cluster -lpaho-mqttpp3 -lpaho-mqtt3a -lpthread -Iframework -Ialgorithm
+
+#include "lamport.h"
+#include "tokenRing.h"
+#include "naimiTrehel_v3.h"
+#include <random>
+
+Logger *logger = nullptr;
+Config config;
+ErrorSimulator error;
+
+template <typename NodeType>
+void simulate(int id, std::shared_ptr<Comm> comm, std::function<std::unique_ptr<NodeType>(int, std::shared_ptr<Comm>)> create) {
+    std::unique_ptr<NodeType> node = create(id, comm);
+
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> distrib(1, 10);
+
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(distrib(gen)));
+        node->enter();
+        {
+            json note;
+            note["status"] = "ok";
+            logger->log("notice", id, std::to_string(id) + " enter critical section", note);
+            std::this_thread::sleep_for(std::chrono::seconds(distrib(gen)));
+            logger->log("notice", id, std::to_string(id) + " exit critical section", note);
+        }
+        node->exit();
+    }
+}
+
+// bao cac thuat toan de vong lap mo phong dung chung mot giao dien
+template <typename Algorithm>
+struct TokenNode : Algorithm {
+    using Algorithm::Algorithm;
+    void enter() { this->requestToken(); }
+    void exit() { this->releaseToken(); }
+};
+
+template <typename Algorithm>
+struct PermissionNode : Algorithm {
+    using Algorithm::Algorithm;
+    void enter() { this->requestPermission(); }
+    void exit() { this->releasePermission(); }
+};
+
+template <typename NodeType>
+void run(std::function<std::unique_ptr<NodeType>(int, std::shared_ptr<Comm>)> create) {
+    int totalNodes = config.getTotalNodes();
+    // tao Comm cua moi node truoc de node nao cung da co hop thu khi ban tin dau tien duoc gui
+    std::vector<std::shared_ptr<Comm>> comms;
+    for (int id = 1; id <= totalNodes; id++) {
+        comms.push_back(std::make_shared<Comm>(id, config.getPort(id)));
+    }
+    std::vector<std::thread> nodes;
+    for (int id = 1; id <= totalNodes; id++) {
+        nodes.emplace_back(simulate<NodeType>, id, comms[id - 1], create);
+    }
+    for (auto &t : nodes) {
+        t.join();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <lamport|tokenRing|naimiTrehel>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string algorithm = argv[1];
+    logger = new Logger(0, false, true, false);
+
+    if (algorithm == "lamport") {
+        run<PermissionNode<Lamport>>([](int id, std::shared_ptr<Comm> comm) {
+            return std::make_unique<PermissionNode<Lamport>>(id, config.getAddress(id), config.getPort(id), comm);
+        });
+    } else if (algorithm == "tokenRing") {
+        run<TokenNode<TokenRing>>([](int id, std::shared_ptr<Comm> comm) {
+            return std::make_unique<TokenNode<TokenRing>>(id, config.getAddress(id), config.getPort(id), comm);
+        });
+    } else if (algorithm == "naimiTrehel") {
+        run<TokenNode<NaimiTrehelV3>>([](int id, std::shared_ptr<Comm> comm) {
+            return std::make_unique<TokenNode<NaimiTrehelV3>>(id, config.getAddress(id), config.getPort(id), 2, comm);
+        });
+    } else {
+        std::cerr << "Unknown algorithm " << algorithm << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+// chi phi CRC32C (checksum.h) cho moi frame o cac kich thuoc ban tin cua Comm
+// g++ -O2 benchmark/checksum_bench.cpp -o benchmark/checksum_bench -Iframework
+
+#include "checksum.h"
+#include "codec.h"
+#include "sequence.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const int ITERATIONS = 2000000;
+
+static volatile uint32_t sink = 0;
+
+template <typename F>
+double measure(const std::string &frame, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink = sink + f(frame.data(), frame.size(), 0);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+// seal + verify tren duong gui/nhan that, gom ca cap phat chuoi
+double measureRoundTrip(const std::string &message) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::string frame = message;
+        FrameChecksum::seal(frame);
+        if (FrameChecksum::verify(frame)) {
+            sink = sink + frame.size();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+int main() {
+    const char check[] = "123456789";
+    if (crc32c(check, 9) != 0xE3069283u || crc32cSoftware(check, 9) != 0xE3069283u) {
+        std::cerr << "crc32c mismatch\n";
+        return 1;
+    }
+
+    // REQUEST khong payload, COMMIT voi k = 3, ban tin inline lon nhat (co va khong phong bi seq)
+    std::vector<std::pair<std::string, size_t>> sizes = {
+        {"REQUEST", Message::HEADER_SIZE},
+        {"COMMIT", Message::HEADER_SIZE + 4 * 4},
+        {"INLINE", Message::INLINE_SIZE},
+        {"INLINE+SEQ", Message::INLINE_SIZE + SequenceHeader::SIZE},
+    };
+
+    std::cout << "hardware crc32c: " << (crc32cHardwareSupported() ? "yes" : "no") << "\n";
+    std::cout << "frame     bytes  software(ns)  crc32c(ns)  seal+verify(ns)\n";
+    for (auto &[name, size] : sizes) {
+        std::string frame(size, '\0');
+        for (size_t i = 0; i < size; i++) {
+            frame[i] = static_cast<char>(i * 31 + 7);
+        }
+        double software = measure(frame, crc32cSoftware);
+        double selected = measure(frame, crc32c);
+        double roundTrip = measureRoundTrip(frame);
+        std::cout << name << "  " << size << "  " << software << "  " << selected << "  " << roundTrip << "\n";
+    }
+    return 0;
+}
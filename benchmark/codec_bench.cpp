@@ -0,0 +1,99 @@
+// so sanh ban tin van ban (to_string + istringstream) voi codec nhi phan (codec.h)
+// g++ -O2 benchmark/codec_bench.cpp -o benchmark/codec_bench -Iframework
+
+#include "codec.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const int ITERATIONS = 1000000;
+static const int K = 3;
+
+static volatile long sink = 0;
+
+template <typename F>
+double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        f(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+// ban tin COMMIT cua naimiTrehel_v3: k nut tien nhiem va vi tri
+void textCommit(int i) {
+    std::string msg = std::to_string(i % 16) + " COMMIT ";
+    for (int j = 1; j < K; j++) {
+        msg += " " + std::to_string(j);
+    }
+    msg += " " + std::to_string(i % 16) + " " + std::to_string(i);
+
+    std::istringstream iss(msg);
+    int source;
+    std::string type;
+    iss >> source >> type;
+    std::vector<int> predecessors(K);
+    int pos;
+    for (int j = 0; j < K; j++) {
+        iss >> predecessors[j];
+    }
+    iss >> pos;
+    if (type == "COMMIT") {
+        sink = sink + source + pos + predecessors[0];
+    }
+}
+
+void binaryCommit(int i) {
+    Message out(MsgType::COMMIT, i % 16);
+    for (int j = 1; j < K; j++) {
+        out.push(j);
+    }
+    out.push(i % 16);
+    out.push(i);
+    char buffer[Message::INLINE_SIZE];
+    size_t size = out.encode(buffer, sizeof(buffer));
+
+    Message in;
+    if (in.decode(buffer, size) && in.type == MsgType::COMMIT) {
+        sink = sink + in.source + in.value(K) + in.value(0);
+    }
+}
+
+// ban tin REQUEST cua lamport: id va timestamp
+void textRequest(int i) {
+    std::string msg = std::to_string(i % 16) + " REQUEST " + std::to_string(i);
+    std::istringstream iss(msg);
+    int source;
+    std::string type;
+    int timestamp;
+    iss >> source >> type >> timestamp;
+    if (type == "REQUEST") {
+        sink = sink + source + timestamp;
+    }
+}
+
+void binaryRequest(int i) {
+    Message out(MsgType::REQUEST, i % 16, i);
+    char buffer[Message::INLINE_SIZE];
+    size_t size = out.encode(buffer, sizeof(buffer));
+
+    Message in;
+    if (in.decode(buffer, size) && in.type == MsgType::REQUEST) {
+        sink = sink + in.source + in.timestamp;
+    }
+}
+
+int main() {
+    double textReq = measure(textRequest);
+    double binReq = measure(binaryRequest);
+    double textCom = measure(textCommit);
+    double binCom = measure(binaryCommit);
+
+    std::cout << "message   text(ns)  binary(ns)  speedup\n";
+    std::cout << "REQUEST   " << textReq << "  " << binReq << "  " << textReq / binReq << "x\n";
+    std::cout << "COMMIT    " << textCom << "  " << binCom << "  " << textCom / binCom << "x\n";
+    return 0;
+}
@@ -0,0 +1,81 @@
+// so sanh ban ghi log JSON (Logger::emit) voi dinh dang nhi phan (logformat.h): byte va ns moi ban ghi
+// g++ -O2 benchmark/logformat_bench.cpp -o benchmark/logformat_bench -Iframework
+
+#include "logformat.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using json = nlohmann::ordered_json;
+
+static const int ITERATIONS = 1000000;
+static const std::string TIME_INIT = "2024-01-01 00:00:00";
+
+static volatile long sink = 0;
+
+template <typename F>
+double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        f(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+// note cua ban ghi gui REQUEST (naimiTrehel): nguon, dich, trang thai
+json sendNote(int i) {
+    json note;
+    note["source"] = i % 16;
+    note["dest"] = (i + 1) % 16;
+    note["status"] = "ok";
+    return note;
+}
+
+// note cua ban ghi nhan TOKEN: last, next, thoi diem
+json receiveNote(int i) {
+    json note;
+    note["last"] = i % 16;
+    note["next"] = nullptr;
+    note["init"] = i;
+    return note;
+}
+
+// dong JSON nhu Logger::write + emit
+std::string textRecord(int i, const json &note, const std::string &type) {
+    json data;
+    data["timeInit"] = TIME_INIT;
+    data["duration_ms"] = i / 1000;
+    data["type"] = type;
+    data["id"] = i % 16;
+    data["content"] = "REQUEST";
+    std::string line = data.dump();
+    line.pop_back();
+    line += ",\"note\":";
+    line += note.dump();
+    line += "}\n";
+    return line;
+}
+
+std::string binaryRecord(BinaryLog::Writer &writer, int i, const json &note, const std::string &type) {
+    std::string out;
+    writer.append(out, static_cast<uint64_t>(i) * 10, type, i % 16, "REQUEST", BinaryLog::encodeNote(note));
+    return out;
+}
+
+int main() {
+    BinaryLog::Writer writer;
+    std::string header;
+    writer.session(header, 1, TIME_INIT);
+
+    double bytes[4] = {0, 0, 0, 0};
+    double textSend = measure([&](int i) { std::string r = textRecord(i, sendNote(i), "send"); bytes[0] += r.size(); sink = sink + r.size(); });
+    double binSend = measure([&](int i) { std::string r = binaryRecord(writer, i, sendNote(i), "send"); bytes[1] += r.size(); sink = sink + r.size(); });
+    double textRecv = measure([&](int i) { std::string r = textRecord(i, receiveNote(i), "receive"); bytes[2] += r.size(); sink = sink + r.size(); });
+    double binRecv = measure([&](int i) { std::string r = binaryRecord(writer, i, receiveNote(i), "receive"); bytes[3] += r.size(); sink = sink + r.size(); });
+
+    std::cout << "record    json(ns)  binary(ns)  json(B)  binary(B)\n";
+    std::cout << "send      " << textSend << "  " << binSend << "  " << bytes[0] / ITERATIONS << "  " << bytes[1] / ITERATIONS << "\n";
+    std::cout << "receive   " << textRecv << "  " << binRecv << "  " << bytes[2] / ITERATIONS << "  " << bytes[3] / ITERATIONS << "\n";
+    return 0;
+}
@@ -0,0 +1,224 @@
+// kiem tra pipeline cua MqttLoggingMethod voi broker gia: cua so (MQTT_WINDOW), lo (MQTT_BATCH),
+// bo ban ghi khi hang doi day (MQTT_QUEUE_LIMIT) va han xac nhan khi broker khong bao gio xac
+// nhan; in thoi gian moi kich ban, tra ve 1 neu sai
+// g++ -O2 benchmark/mqtt_pipeline_bench.cpp -o benchmark/mqtt_pipeline_bench -Iframework -lpthread
+// chay o thu muc co config.env (topic, qos)
+
+#include "log.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+Config config;
+
+typedef std::chrono::steady_clock Clock;
+
+// Broker gia: ghi lai moi ban tin theo thu tu publish, xac nhan sau ackDelay. Khi dong cong
+// (gated) khong xac nhan gi cho toi khi open(), de cua so va hang doi cua sink bi day; khong
+// open() thi moi ban tin deu mat.
+class FakeBroker {
+public:
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::chrono::microseconds ackDelay;
+    bool gated;
+    std::vector<std::string> payloads;
+    size_t outstanding = 0;
+    size_t maxOutstanding = 0;
+
+    FakeBroker(std::chrono::microseconds ackDelay, bool gated) : ackDelay(ackDelay), gated(gated) {}
+
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            gated = false;
+        }
+        cond.notify_all();
+    }
+};
+
+class FakeDelivery : public MqttDelivery {
+private:
+    FakeBroker &broker;
+    Clock::time_point due;
+    bool done = false;
+
+public:
+    FakeDelivery(FakeBroker &broker) : broker(broker), due(Clock::now() + broker.ackDelay) {}
+
+    bool complete() override {
+        std::lock_guard<std::mutex> lock(broker.mtx);
+        if (!done && !broker.gated && Clock::now() >= due) {
+            finish();
+        }
+        return done;
+    }
+
+    bool wait(std::chrono::milliseconds timeout) override {
+        std::unique_lock<std::mutex> lock(broker.mtx);
+        if (!broker.cond.wait_for(lock, timeout, [this]() { return done || !broker.gated; })) {
+            return false;
+        }
+        lock.unlock();
+        std::this_thread::sleep_until(due);
+        lock.lock();
+        if (!done) {
+            finish();
+        }
+        return true;
+    }
+
+private:
+    // goi khi dang giu broker.mtx
+    void finish() {
+        done = true;
+        broker.outstanding--;
+    }
+};
+
+class FakeMqttLink : public MqttLink {
+private:
+    FakeBroker &broker;
+
+public:
+    explicit FakeMqttLink(FakeBroker &broker) : broker(broker) {}
+
+    void connect() override {}
+    void disconnect() override {}
+
+    std::unique_ptr<MqttDelivery> publish(const std::string &, const std::string &payload, int) override {
+        std::lock_guard<std::mutex> lock(broker.mtx);
+        broker.payloads.push_back(payload);
+        broker.outstanding++;
+        broker.maxOutstanding = std::max(broker.maxOutstanding, broker.outstanding);
+        return std::make_unique<FakeDelivery>(broker);
+    }
+};
+
+struct Scenario {
+    const char *name;
+    size_t window;
+    size_t batch;
+    size_t queueLimit;
+    size_t records;
+    std::chrono::microseconds ackDelay;
+    bool gated;
+    bool lost = false;                          // broker khong bao gio xac nhan (cong dong mai)
+    std::chrono::milliseconds timeout = MqttLoggingMethod::PUBLISH_TIMEOUT;
+};
+
+struct Outcome {
+    MqttLogStats held;          // luc cong con dong (chi khi gated)
+    MqttLogStats stats;         // sau clean()
+    size_t maxOutstanding;
+    size_t maxBatch;
+    size_t messages;
+    size_t received;            // so ban ghi broker nhan duoc
+    bool ordered;               // ban ghi tang dan, khong lap
+    double ms;
+};
+
+Outcome run(const Scenario &scenario) {
+    FakeBroker broker(scenario.ackDelay, scenario.gated || scenario.lost);
+    Outcome outcome{};
+    auto start = Clock::now();
+    {
+        MqttLoggingMethod sink(1, std::make_unique<FakeMqttLink>(broker), scenario.window, scenario.batch,
+                               scenario.queueLimit, scenario.timeout);
+        sink.init();
+        for (size_t i = 0; i < scenario.records; i++) {
+            sink.log(1, std::to_string(i));
+        }
+        if (scenario.gated) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            outcome.held = sink.getStats();
+            broker.open();
+        }
+        sink.clean();
+        outcome.stats = sink.getStats();
+    }
+    outcome.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    outcome.maxOutstanding = broker.maxOutstanding;
+    outcome.messages = broker.payloads.size();
+    outcome.ordered = true;
+    long previous = -1;
+    for (auto &payload : broker.payloads) {
+        std::istringstream in(payload);
+        std::string line;
+        size_t count = 0;
+        while (std::getline(in, line)) {
+            long value = std::stol(line);
+            outcome.ordered = outcome.ordered && value > previous;
+            previous = value;
+            count++;
+        }
+        outcome.maxBatch = std::max(outcome.maxBatch, count);
+        outcome.received += count;
+    }
+    return outcome;
+}
+
+static int failures = 0;
+
+void check(const char *scenario, const char *what, bool ok) {
+    if (!ok) {
+        std::cout << "FAIL " << scenario << ": " << what << "\n";
+        failures++;
+    }
+}
+
+int main() {
+    const std::chrono::microseconds ack(2000);
+    Scenario window{"window", 4, 16, 100000, 20000, ack, false};
+    Scenario batch{"batch", 1, 32, 100000, 5000, ack, false};
+    Scenario serial{"serial", 1, 1, 100000, 500, ack, false};
+    Scenario limit{"queue limit", 2, 8, 1000, 5000, ack, true};
+    // cua so khong bao gio day: ban tin mat phai bi bo sau han va clean() khong bi treo
+    Scenario lost{"lost", 8, 4, 100000, 10, ack, false, true, std::chrono::milliseconds(50)};
+    // cua so day va con hang doi khi dung: clean() chi gui not toi han, phan con lai bi bo
+    Scenario drain{"lost backlog", 2, 4, 100000, 1000, ack, false, true, std::chrono::milliseconds(50)};
+
+    std::cout << "scenario     window  batch  records  messages  max in flight  max batch  dropped  ms\n";
+    for (const Scenario *scenario : {&serial, &window, &batch, &limit, &lost, &drain}) {
+        Outcome o = run(*scenario);
+        std::cout << scenario->name << "  " << scenario->window << "  " << scenario->batch << "  " << o.received << "  "
+                  << o.messages << "  " << o.maxOutstanding << "  " << o.maxBatch << "  " << o.stats.dropped << "  "
+                  << o.ms << "\n";
+
+        const char *name = scenario->name;
+        check(name, "more messages in flight than MQTT_WINDOW", o.maxOutstanding <= scenario->window);
+        check(name, "message larger than MQTT_BATCH", o.maxBatch <= scenario->batch);
+        check(name, "records reordered or duplicated", o.ordered);
+        check(name, "backlog or in-flight left after clean", o.stats.backlog == 0 && o.stats.inFlight == 0);
+        if (scenario->lost) {
+            check(name, "records neither published nor dropped", o.received + o.stats.dropped == scenario->records);
+            check(name, "lost deliveries not counted as failures", o.messages > 0 && o.stats.failures == o.messages);
+            check(name, "lost deliveries counted as acknowledged", o.stats.records == 0 && o.stats.messages == 0);
+            check(name, "clean() not bounded by the publish timeout", o.ms < 4 * scenario->timeout.count() + 200);
+            continue;
+        }
+        check(name, "broker and stats disagree", o.received == o.stats.records && o.messages == o.stats.messages);
+        check(name, "records lost", o.stats.records + o.stats.dropped == scenario->records);
+        check(name, "failed deliveries", o.stats.failures == 0);
+        if (scenario->gated) {
+            // cua so day, sink dung o ban tin cu nhat; hang doi da cham gioi han (tru phan da vao cua so) moi bo
+            check(name, "queue not filled to MQTT_QUEUE_LIMIT",
+                  o.held.backlog + scenario->window * scenario->batch >= scenario->queueLimit);
+            check(name, "window not full while broker held", o.held.inFlight == scenario->window);
+            check(name, "nothing dropped at the queue limit", o.held.dropped > 0 && o.stats.dropped == o.held.dropped);
+            check(name, "records accepted outside queue and window",
+                  o.stats.records >= scenario->queueLimit &&
+                  o.stats.records <= scenario->queueLimit + scenario->window * scenario->batch);
+        } else {
+            check(name, "dropped below the queue limit", o.stats.dropped == 0);
+            // ghi nhanh hon broker xac nhan nhieu nen cua so va lo deu phai day
+            check(name, "window never filled", o.maxOutstanding == scenario->window);
+            check(name, "batches never filled", o.maxBatch == scenario->batch);
+        }
+    }
+
+    std::cout << (failures == 0 ? "ok\n" : "failed\n");
+    return failures == 0 ? 0 : 1;
+}
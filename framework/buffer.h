@@ -0,0 +1,251 @@
+// buffer.h
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+class BufferPool;
+
+// Khoi nho cua pool: phan dau la dem tham chieu, du lieu nam ngay sau
+struct BufferBlock {
+    std::atomic<uint32_t> refs;
+    uint32_t capacity;
+    BufferPool *pool;               // pool da cap khoi; khoi lon hon BLOCK_SIZE duoc giai phong khi tra
+    BufferBlock *nextFree;
+
+    char *data() {
+        return reinterpret_cast<char *>(this + 1);
+    }
+};
+
+// Khung nhin chi doc len mot khoi cua BufferPool, dem tham chieu. Copy Buffer chi tang
+// dem tham chieu; cat header/duoi frame chi doi khung nhin. Khoi tro ve pool khi Buffer
+// cuoi cung tro toi no bi huy. Buffer phai duoc tra het truoc khi pool bi huy.
+class Buffer {
+private:
+    BufferBlock *block = nullptr;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+
+    friend class BufferPool;
+
+    Buffer(BufferBlock *block, uint32_t length) : block(block), length(length) {}
+
+public:
+    Buffer() = default;
+
+    Buffer(const Buffer &other) : block(other.block), offset(other.offset), length(other.length) {
+        if (block != nullptr) {
+            block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Buffer(Buffer &&other) noexcept : block(other.block), offset(other.offset), length(other.length) {
+        other.block = nullptr;
+        other.offset = other.length = 0;
+    }
+
+    Buffer &operator=(const Buffer &other) {
+        if (this != &other) {
+            Buffer copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    Buffer &operator=(Buffer &&other) noexcept {
+        if (this != &other) {
+            reset();
+            block = other.block;
+            offset = other.offset;
+            length = other.length;
+            other.block = nullptr;
+            other.offset = other.length = 0;
+        }
+        return *this;
+    }
+
+    ~Buffer() {
+        reset();
+    }
+
+    const char *data() const {
+        return block == nullptr ? "" : block->data() + offset;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    char operator[](size_t index) const {
+        return data()[index];
+    }
+
+    std::string_view view() const {
+        return std::string_view(data(), length);
+    }
+
+    std::string str() const {
+        return std::string(data(), length);
+    }
+
+    // bo n byte dau (header cua tang duoi); truoc day la substr, mot lan cap phat
+    inline void removePrefix(size_t n);
+
+    // bo n byte cuoi (duoi checksum)
+    void removeSuffix(size_t n) {
+        length -= static_cast<uint32_t>(n < length ? n : length);
+    }
+
+    inline void reset();
+};
+
+struct BufferStats {
+    uint64_t acquired;          // so buffer da cap cho ban tin nhan duoc
+    uint64_t reused;            // lay lai tu slab, khong cap phat
+    uint64_t allocated;         // khoi moi cap phat cho slab (slab chua du)
+    uint64_t oversized;         // ban tin lon hon BLOCK_SIZE, cap phat rieng
+    uint64_t slices;            // cat header bang khung nhin thay cho substr (khong tinh la cap phat)
+    size_t outstanding;         // so khoi dang duoc giu (trong hop thu, o thuat toan...)
+
+    // ti le ban tin nhan vao khoi lay lai tu slab thay vi cap phat moi
+    double reuseRate() const {
+        return acquired == 0 ? 0.0 : static_cast<double>(reused) / acquired;
+    }
+};
+
+// Slab cua mot node: cac khoi kich thuoc co dinh (du cho moi ban tin codec cung cac
+// header cua transport) duoc tai su dung qua danh sach tu do. Nhieu luong nhan lay khoi,
+// luong thuat toan tra khoi; danh sach tu do duoc bao ve bang mot mutex ngan.
+class BufferPool {
+public:
+    static const size_t BLOCK_SIZE = 256;
+
+private:
+    std::mutex mtx;
+    BufferBlock *freeList = nullptr;
+    size_t freeCount = 0;
+    size_t maxFree;
+    std::atomic<uint64_t> acquired{0};
+    std::atomic<uint64_t> reused{0};
+    std::atomic<uint64_t> allocated{0};
+    std::atomic<uint64_t> oversized{0};
+    std::atomic<uint64_t> slices{0};
+    std::atomic<size_t> outstanding{0};
+
+    friend class Buffer;
+
+public:
+    explicit BufferPool(size_t maxFree = 4096) : maxFree(maxFree) {}
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    ~BufferPool() {
+        while (freeList != nullptr) {
+            BufferBlock *block = freeList;
+            freeList = block->nextFree;
+            destroy(block);
+        }
+    }
+
+    // lay mot khoi va chep du lieu vao
+    Buffer copy(const char *data, size_t size) {
+        acquired.fetch_add(1, std::memory_order_relaxed);
+        BufferBlock *block = nullptr;
+        if (size <= BLOCK_SIZE) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (freeList != nullptr) {
+                    block = freeList;
+                    freeList = block->nextFree;
+                    freeCount--;
+                }
+            }
+            if (block != nullptr) {
+                reused.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                block = create(BLOCK_SIZE);
+                allocated.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else {
+            block = create(size);
+            oversized.fetch_add(1, std::memory_order_relaxed);
+        }
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        block->refs.store(1, std::memory_order_relaxed);
+        memcpy(block->data(), data, size);
+        return Buffer(block, static_cast<uint32_t>(size));
+    }
+
+    Buffer copy(std::string_view data) {
+        return copy(data.data(), data.size());
+    }
+
+    BufferStats getStats() const {
+        return BufferStats{acquired.load(), reused.load(), allocated.load(), oversized.load(),
+                           slices.load(), outstanding.load()};
+    }
+
+private:
+    BufferBlock *create(size_t capacity) {
+        void *memory = ::operator new(sizeof(BufferBlock) + capacity);
+        BufferBlock *block = new (memory) BufferBlock;
+        block->capacity = static_cast<uint32_t>(capacity);
+        block->pool = this;
+        block->nextFree = nullptr;
+        return block;
+    }
+
+    static void destroy(BufferBlock *block) {
+        block->~BufferBlock();
+        ::operator delete(block);
+    }
+
+    void release(BufferBlock *block) {
+        outstanding.fetch_sub(1, std::memory_order_relaxed);
+        if (block->capacity != BLOCK_SIZE) {
+            destroy(block);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (freeCount < maxFree) {
+                block->nextFree = freeList;
+                freeList = block;
+                freeCount++;
+                return;
+            }
+        }
+        destroy(block);
+    }
+};
+
+inline void Buffer::removePrefix(size_t n) {
+    n = n < length ? n : length;
+    offset += static_cast<uint32_t>(n);
+    length -= static_cast<uint32_t>(n);
+    if (block != nullptr) {
+        block->pool->slices.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+inline void Buffer::reset() {
+    if (block != nullptr && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block->pool->release(block);
+    }
+    block = nullptr;
+    offset = length = 0;
+}
+
+#endif // BUFFER_H
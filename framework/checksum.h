@@ -0,0 +1,125 @@
+// checksum.h
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <string>
+#include "buffer.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42 1
+#endif
+
+// CRC32C (Castagnoli, da thuc dao 0x82F63B78). crc la gia tri tra ve cua lan goi truoc
+// nen co the tinh tiep tren nhieu doan du lieu: crc32c(b, nb, crc32c(a, na)).
+
+inline uint32_t crc32cSoftware(const void *data, size_t size, uint32_t crc = 0) {
+    static const struct Table {
+        uint32_t entries[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    value = (value & 1) ? (value >> 1) ^ 0x82F63B78u : value >> 1;
+                }
+                entries[i] = value;
+            }
+        }
+    } table;
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42
+// lenh crc32 cua SSE4.2, 8 byte mot lan; chi goi khi CPU ho tro (xem crc32c)
+__attribute__((target("sse4.2")))
+inline uint32_t crc32cHardware(const void *data, size_t size, uint32_t crc = 0) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+#ifdef __x86_64__
+    uint64_t wide = crc;
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<uint32_t>(wide);
+#endif
+    for (; size >= 4; size -= 4, p += 4) {
+        uint32_t word;
+        memcpy(&word, p, 4);
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; size > 0; size--, p++) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+    return ~crc;
+}
+
+inline bool crc32cHardwareSupported() {
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+}
+#else
+inline bool crc32cHardwareSupported() {
+    return false;
+}
+#endif
+
+inline uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0) {
+#ifdef CRC32C_HAVE_SSE42
+    if (crc32cHardwareSupported()) {
+        return crc32cHardware(data, size, crc);
+    }
+#endif
+    return crc32cSoftware(data, size, crc);
+}
+
+// Duoi kiem tra dat cuoi moi frame cua Comm: ban tin | crc32c(4, big-endian)
+struct FrameChecksum {
+    static const size_t SIZE = 4;
+
+    static void seal(std::string &frame) {
+        uint32_t crc = crc32c(frame.data(), frame.size());
+        char trailer[SIZE] = {static_cast<char>(crc >> 24), static_cast<char>(crc >> 16),
+                              static_cast<char>(crc >> 8), static_cast<char>(crc)};
+        frame.append(trailer, SIZE);
+    }
+
+    // bo duoi neu frame nguyen ven; tra ve false (frame giu nguyen) neu sai checksum
+    static bool verify(std::string &frame) {
+        if (!check(frame.data(), frame.size())) {
+            return false;
+        }
+        frame.resize(frame.size() - SIZE);
+        return true;
+    }
+
+    static bool verify(Buffer &frame) {
+        if (!check(frame.data(), frame.size())) {
+            return false;
+        }
+        frame.removeSuffix(SIZE);
+        return true;
+    }
+
+private:
+    static bool check(const char *data, size_t size) {
+        if (size < SIZE) {
+            return false;
+        }
+        size -= SIZE;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(data + size);
+        uint32_t expected = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                            (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+        return crc32c(data, size) == expected;
+    }
+};
+
+#endif // CHECKSUM_H
@@ -0,0 +1,211 @@
+// codec.h
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Dinh dang nhi phan chung cho ban tin cua cac thuat toan, thay cho chuoi van ban
+// "id TYPE so..." va istringstream. Encode/decode khong cap phat bo nho: encode ghi
+// vao bo dem cua nguoi goi, decode doc thang tu bo dem nhan duoc.
+//
+//   version(1) | type(1) | source(4) | sequence(4) | timestamp(4) | count(4) | values(4 * count)
+//
+// So nguyen theo big-endian. Byte dau la phien ban dinh dang, ban tin khac phien ban bi tu choi.
+
+enum class MsgType : uint8_t {
+    // lamport
+    REQUEST = 1,
+    OK,
+    RELEASE,
+    // token ring, naimi-trehel
+    TOKEN,
+    COMMIT,                 // values: cac nut tien nhiem, vi tri trong hang doi
+    // naimi-trehel v2
+    CONSULT,
+    ACK_CONSULT,
+    FAILURE,
+    ACK_FAILURE,
+    ELECTION,
+    ELECTED,
+    // naimi-trehel v3
+    ARE_YOU_ALIVE,
+    I_AM_ALIVE,
+    REQUEST_M1,
+    SEARCH_PREV,            // values: vi tri
+    ACK_SEARCH_PREV,        // values: vi tri
+    SEARCH_QUEUE,           // values: so lan vao CS
+    ACK_SEARCH_QUEUE,       // values: vi tri, next
+    CONNECTION,
+    REGENERATED,
+    PING,
+    PONG,
+    LAST = PONG
+};
+
+inline const char *msgTypeName(MsgType type) {
+    static const char *names[] = {
+        "UNKNOWN", "REQUEST", "OK", "RELEASE", "TOKEN", "COMMIT",
+        "CONSULT", "ACK_CONSULT", "FAILURE", "ACK_FAILURE", "ELECTION", "ELECTED",
+        "ARE_YOU_ALIVE", "I_AM_ALIVE", "REQUEST_M1", "SEARCH_PREV", "ACK_SEARCH_PREV",
+        "SEARCH_QUEUE", "ACK_SEARCH_QUEUE", "CONNECTION", "REGENERATED", "PING", "PONG"
+    };
+    uint8_t index = static_cast<uint8_t>(type);
+    return index <= static_cast<uint8_t>(MsgType::LAST) ? names[index] : names[0];
+}
+
+// Lop uu tien cua ban tin. Comm co hop thu va hang doi gui rieng cho tung lop, lop cao
+// hon (so nho hon) luon duoc phuc vu truoc. Thu tu FIFO chi duoc giu trong cung mot lop:
+// cac ban tin ma thu tu giua chung quan trong phai cung lop.
+enum class Priority : uint8_t {
+    CONTROL = 0,            // token, nhip tim: tre la sai lech giao thuc
+    NORMAL,                 // mac dinh
+    BULK                    // broadcast phuc hoi, co the cho
+};
+
+static const size_t PRIORITY_CLASSES = 3;
+
+inline const char *priorityName(Priority priority) {
+    static const char *names[] = {"CONTROL", "NORMAL", "BULK"};
+    return names[static_cast<size_t>(priority)];
+}
+
+// lop uu tien cua tung MsgType, chi so la gia tri cua type
+typedef std::array<Priority, static_cast<size_t>(MsgType::LAST) + 1> PriorityTable;
+
+// Ban tin da giai ma, payload la day so nguyen co kieu duoc dien giai theo type (xem chu
+// thich trong MsgType). So gia tri khong gioi han: toi da INLINE_VALUES gia tri nam ngay
+// trong Message, day dai hon khong duoc chep - list() tham chieu mang cua nguoi goi, decode
+// tham chieu frame nhan duoc - nen Message khong duoc song lau hon mang/frame do.
+struct Message {
+    static const uint8_t WIRE_VERSION = 2;
+    static const size_t HEADER_SIZE = 18;
+    static const size_t INLINE_VALUES = 16;
+    static const size_t INLINE_SIZE = HEADER_SIZE + 4 * INLINE_VALUES;   // du cho moi ban tin chi dung push
+
+    MsgType type;
+    int32_t source;
+    uint32_t sequence;
+    int32_t timestamp;          // dong ho Lamport
+    uint32_t count;             // tong so gia tri
+
+    Message() : type(MsgType::REQUEST), source(0), sequence(0), timestamp(0), count(0) {}
+
+    Message(MsgType type, int32_t source, int32_t timestamp = 0)
+        : type(type), source(source), sequence(0), timestamp(timestamp), count(0) {}
+
+    // dat day gia tri dau payload bang mang cua nguoi goi (khong chep); cac gia tri push
+    // sau do dung sau day nay. Goi truoc push, mot lan cho moi ban tin
+    void list(const int32_t *data, size_t size) {
+        listData = data;
+        listSize = static_cast<uint32_t>(size);
+        count = listSize + inlineCount;
+    }
+
+    // tra ve false neu phan inline da day (gia tri bi bo); day dai dung list()
+    bool push(int32_t value) {
+        if (inlineCount >= INLINE_VALUES || encoded != nullptr) {
+            return false;
+        }
+        values[inlineCount++] = value;
+        count = listSize + inlineCount;
+        return true;
+    }
+
+    // gia tri thu index cua payload, fallback neu ban tin khong co
+    int32_t value(size_t index, int32_t fallback = -1) const {
+        if (index >= count) {
+            return fallback;
+        }
+        if (encoded != nullptr) {
+            return static_cast<int32_t>(get32(encoded + HEADER_SIZE + 4 * index));
+        }
+        return index < listSize ? listData[index] : values[index - listSize];
+    }
+
+    size_t encodedSize() const {
+        return HEADER_SIZE + 4 * static_cast<size_t>(count);
+    }
+
+    // ghi ban tin vao buffer, tra ve so byte da ghi hoac 0 neu buffer khong du
+    size_t encode(char *buffer, size_t capacity) const {
+        size_t size = encodedSize();
+        if (capacity < size) {
+            return 0;
+        }
+        buffer[0] = static_cast<char>(WIRE_VERSION);
+        buffer[1] = static_cast<char>(type);
+        put32(buffer + 2, static_cast<uint32_t>(source));
+        put32(buffer + 6, sequence);
+        put32(buffer + 10, static_cast<uint32_t>(timestamp));
+        put32(buffer + 14, count);
+        if (encoded != nullptr) {
+            memcpy(buffer + HEADER_SIZE, encoded + HEADER_SIZE, size - HEADER_SIZE);
+            return size;
+        }
+        char *out = buffer + HEADER_SIZE;
+        for (uint32_t i = 0; i < listSize; i++, out += 4) {
+            put32(out, static_cast<uint32_t>(listData[i]));
+        }
+        for (uint32_t i = 0; i < inlineCount; i++, out += 4) {
+            put32(out, static_cast<uint32_t>(values[i]));
+        }
+        return size;
+    }
+
+    // tra ve false neu sai phien ban, type la hoac do dai khong khop count.
+    // Day ngan duoc chep vao Message, day dai hon INLINE_VALUES doc thang tu data
+    bool decode(const char *data, size_t size) {
+        if (size < HEADER_SIZE || static_cast<uint8_t>(data[0]) != WIRE_VERSION) {
+            return false;
+        }
+        uint8_t rawType = static_cast<uint8_t>(data[1]);
+        uint32_t rawCount = get32(data + 14);
+        if (rawType == 0 || rawType > static_cast<uint8_t>(MsgType::LAST) ||
+            (size - HEADER_SIZE) % 4 != 0 || (size - HEADER_SIZE) / 4 != rawCount) {
+            return false;
+        }
+        type = static_cast<MsgType>(rawType);
+        source = static_cast<int32_t>(get32(data + 2));
+        sequence = get32(data + 6);
+        timestamp = static_cast<int32_t>(get32(data + 10));
+        count = rawCount;
+        listData = nullptr;
+        listSize = 0;
+        if (rawCount > INLINE_VALUES) {
+            encoded = data;
+            inlineCount = 0;
+            return true;
+        }
+        encoded = nullptr;
+        inlineCount = rawCount;
+        for (uint32_t i = 0; i < rawCount; i++) {
+            values[i] = static_cast<int32_t>(get32(data + HEADER_SIZE + 4 * i));
+        }
+        return true;
+    }
+
+private:
+    const int32_t *listData = nullptr;     // list(): mang cua nguoi goi
+    uint32_t listSize = 0;
+    const char *encoded = nullptr;         // decode ban tin dai: frame nhan duoc
+    uint32_t inlineCount = 0;
+    int32_t values[INLINE_VALUES];
+
+    static void put32(char *out, uint32_t value) {
+        out[0] = static_cast<char>(value >> 24);
+        out[1] = static_cast<char>(value >> 16);
+        out[2] = static_cast<char>(value >> 8);
+        out[3] = static_cast<char>(value);
+    }
+
+    static uint32_t get32(const char *in) {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(in);
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+};
+
+#endif // CODEC_H
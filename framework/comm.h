@@ -6,70 +6,330 @@
 #include "log.h"
 #include "node.h"
 #include "error.h"
+#include "transport.h"
+#include "uring.h"
+#include "udp.h"
+#include "shm.h"
+#include "ring.h"
+#include "outbox.h"
+#include "codec.h"
+#include "sequence.h"
+#include "checksum.h"
+#include "buffer.h"
+#include "metrics.h"
 #include <string>
 #include <cstring>
-#include <queue>
 #include <mutex>
 #include <map>
 #include <vector>
 #include <memory>
-#include <condition_variable>
-#include <netinet/in.h>
 #include <thread>
-#include <unistd.h>
-#include <arpa/inet.h>
+#include <future>
+#include <condition_variable>
 
 extern Logger *logger;
 extern ErrorSimulator error;
 
+// Chon transport theo cau hinh TRANSPORT, quay ve socket neu khong khoi tao duoc
+inline std::unique_ptr<Transport> makeBaseTransport(const std::string &name, int id, int port) {
+    if (name == "shm") {
+        return std::make_unique<ShmTransport>(id);
+    }
+    else if (name == "udp") {
+        return std::make_unique<UdpTransport>(id, port);
+    }
+    else if (name == "uring") {
+        try {
+            return std::make_unique<UringTransport>(port);
+        }
+        catch (const std::exception &e) {
+            std::cerr << "io_uring unavailable (" << e.what() << "), falling back to socket transport\n";
+        }
+    }
+    else if (name != "socket") {
+        std::cerr << "Unknown transport " << name << ", using socket transport\n";
+    }
+    return std::make_unique<SocketTransport>(port, config.getReceiveWorkers());
+}
+
+// RELIABLE=1 boc transport co ket noi bang lop bao nhan / truyen lai (udp da tin cay san)
+inline std::unique_ptr<Transport> makeTransport(const std::string &name, int id, int port) {
+    std::unique_ptr<Transport> transport = makeBaseTransport(name, id, port);
+    if (config.isReliable() && !transport->preservesOrder()) {
+        return std::make_unique<ReliableTransport>(id, std::move(transport), config.getReliableRetries(),
+                                                   std::chrono::milliseconds(config.getReliableMaxRtoMs()));
+    }
+    return transport;
+}
+
+// thoi gian cho cua mot lop uu tien trong hop thu den va hang doi gui
+struct LaneStats {
+    InboxStats inbound;
+    OutboxStats outbound;       // bang 0 khi transport gui thang (udp, shm)
+};
+
 class Comm {
 private:
+    struct FanOut {
+        std::mutex mtx;
+        std::map<int, bool> results;
+        size_t remaining = 0;
+        std::promise<std::map<int, bool>> done;
+    };
+
     int id;
-    int serverSocket;
-    int opt = 1;
-    struct sockaddr_in servaddr;
-    std::mutex socketMutex;                      
-    std::condition_variable messageAvailable;
-    std::queue<std::string> messageQueue; 
-    std::thread m_receiveThread;
+    BufferPool pool;                        // khoi nhan cua node; khai bao truoc de bi huy sau hop thu va transport
+    Inbox<Buffer> inbox;               // hop thu den theo lop uu tien: nhieu luong ghi, luong thuat toan doc
+    // lop uu tien cua tung MsgType do thuat toan khai bao (setPriorities), mac dinh NORMAL
+    std::atomic<Priority> classes[static_cast<size_t>(MsgType::LAST) + 1];
+    std::unique_ptr<Transport> transport;
+    std::unique_ptr<Outbox> outbox;         // hang doi gui theo peer, khi send cua transport co the phai cho
+    std::atomic<uint32_t> sequence{0};      // so thu tu gan vao ban tin nhi phan
+    // dam bao FIFO theo tung cap (nguon, dich) khi transport co the dao thu tu
+    std::unique_ptr<ReorderBuffer> reorder;
+    std::vector<uint32_t> nextSeq;          // seq ke tiep cho tung dich, chi luong I/O cua dich do dung
+    uint32_t session;
+    std::atomic<uint64_t> corruptFrames{0};  // frame sai CRC32C, bo truoc khi vao hop thu
+    bool dropWhenFull = false;              // transport khong cho duoc khi hop thu day (shm)
+    std::atomic<uint64_t> inboxDrops{0};
+    PeerMetrics metrics;                    // dem theo peer, cap nhat tu luong I/O va luong nhan
+    // ghi thong ke vao log moi STATS_INTERVAL_MS va giao ban tin bi giu qua REORDER_TIMEOUT_MS
+    std::thread m_timerThread;
+    std::mutex timerMutex;
+    std::condition_variable timerCond;
+    bool stopping = false;
 
 public:
-    Comm(int id, int port) : id(id) {
-        if ((serverSocket = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-            throw std::runtime_error("Creating socket failed");
+    Comm(int id, int port)
+        : id(id), inbox(config.getInboxCapacity(), PRIORITY_CLASSES), metrics(config.getTotalNodes()) {
+        for (auto &priority : classes) {
+            priority.store(Priority::NORMAL, std::memory_order_relaxed);
+        }
+        transport = makeTransport(config.getTransport(), id, port);
+        if (transport->sendMayBlock() && !transport->preservesOrder()) {
+            reorder = std::make_unique<ReorderBuffer>(config.getTotalNodes(), config.getReorderWindow(),
+                                                      std::chrono::milliseconds(config.getReorderTimeoutMs()));
+            nextSeq.assign(config.getTotalNodes() + 1, 0);
+            session = static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^ (id << 24);
+        }
+        dropWhenFull = !transport->deliverMayBlock();
+        transport->start([this](std::vector<Buffer> &messages) { deliver(messages); }, pool);
+        if (transport->sendMayBlock()) {
+            outbox = std::make_unique<Outbox>(config.getTotalNodes(), config.getIoWorkers(), config.getSendQueueLimit(),
+                [this](int destId, const std::string &message) { return transmit(destId, message); }, PRIORITY_CLASSES);
+        }
+        if (config.getStatsIntervalMs() > 0 || reorder) {
+            m_timerThread = std::thread(&Comm::timerThread, this);
+        }
+    }
+
+    ~Comm() {
+        if (m_timerThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(timerMutex);
+                stopping = true;
+            }
+            timerCond.notify_all();
+            m_timerThread.join();
         }
+        outbox.reset();
+        transport.reset();
+    }
 
-        struct sockaddr_in servaddr;
-        memset(&servaddr, 0, sizeof(servaddr));
-        servaddr.sin_family = AF_INET;
-        servaddr.sin_addr.s_addr = INADDR_ANY;
-        servaddr.sin_port = htons(port);
+    // khong cho mang: ban tin vao hang doi cua peer va duoc gui boi luong I/O,
+    // nen thuat toan co the goi send ngay ca khi dang giu khoa
+    void send(int destId, const std::string& message) {       
+        checkNetworkError();
+        // else if (error.simulateMessageLoss()) {
+        //     return;
+        // }
+        // else if (error.simulateMessageDelay()) {
+        //     std::this_thread::sleep_for(std::chrono::seconds(1));
+        // }
 
-        if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt))) {
-            throw std::runtime_error("Error setting socket options");
+        if (outbox) {
+            outbox->push(destId, laneOf(message), std::make_shared<const std::string>(frame(message)));
+        } else {
+            std::string framed = frame(message);
+            metrics.sent(destId, framed.size(), transport->send(destId, framed));
         }
+    }
 
-        if (bind(serverSocket, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
-            close(serverSocket);
-            throw std::runtime_error("Bind failed");
+    // ma hoa ban tin nhi phan (codec.h) thang vao chuoi gui, vua dung so gia tri cua ban tin
+    void send(int destId, Message message) {
+        message.sequence = sequence++;
+        std::string encoded(message.encodedSize(), '\0');
+        message.encode(&encoded[0], encoded.size());
+        send(destId, encoded);
+    }
+
+    // gui toi mot tap node; cac dich duoc gui song song va ket qua tung dich
+    // (true = da gui) co trong future khi tat ca hoan tat
+    std::future<std::map<int, bool>> multicast(const std::vector<int> &dests, const std::string& message) {
+        checkNetworkError();
+        auto state = std::make_shared<FanOut>();
+        std::future<std::map<int, bool>> result = state->done.get_future();
+        if (dests.empty()) {
+            state->done.set_value({});
+            return result;
+        }
+        if (!outbox) {
+            // transport khong phai cho (udp/shm): gop ca lo trong mot lan goi
+            std::string framed = frame(message);
+            std::vector<bool> ok = transport->sendMany(dests, framed);
+            std::map<int, bool> results;
+            for (size_t i = 0; i < dests.size(); i++) {
+                results[dests[i]] = ok[i];
+                metrics.sent(dests[i], framed.size(), ok[i]);
+            }
+            state->done.set_value(results);
+            return result;
         }
+        state->remaining = dests.size();
+        auto payload = std::make_shared<const std::string>(frame(message));
+        size_t lane = laneOf(message);
+        for (int dest : dests) {
+            outbox->push(dest, lane, payload, [state, dest](bool ok) {
+                std::lock_guard<std::mutex> lock(state->mtx);
+                state->results[dest] = ok;
+                if (--state->remaining == 0) {
+                    state->done.set_value(state->results);
+                }
+            });
+        }
+        return result;
+    }
 
-        if (::listen(serverSocket, 5) < 0) {
-            throw std::runtime_error("Listen failed");
-            close(serverSocket);
+    // gui toi tat ca node khac
+    std::future<std::map<int, bool>> broadcast(const std::string& message) {
+        std::vector<int> dests;
+        for (int i = 1; i <= config.getTotalNodes(); i++) {
+            if (i != id) {
+                dests.push_back(i);
+            }
         }
+        return multicast(dests, message);
+    }
 
-        m_receiveThread = std::thread(&Comm::receiveThread, this);
+    std::future<std::map<int, bool>> broadcast(Message message) {
+        message.sequence = sequence++;
+        std::string encoded(message.encodedSize(), '\0');
+        message.encode(&encoded[0], encoded.size());
+        return broadcast(encoded);
     }
 
-    ~Comm() {
-        if (m_receiveThread.joinable()) {
-            m_receiveThread.join();
+    // lop uu tien cua tung MsgType, thuat toan goi mot lan khi khoi tao (Dispatcher::priorities)
+    void setPriorities(const PriorityTable &table) {
+        for (size_t i = 0; i < table.size(); i++) {
+            classes[i].store(table[i], std::memory_order_relaxed);
         }
-        close(serverSocket);
     }
 
-    void send(int destId, const std::string& message) {       
+    // chep ban tin ra chuoi, cho cac thuat toan cu
+    int getMessage(std::string& msg) {
+        Buffer message;
+        inbox.pop(message);
+        msg = message.str();
+        return 1;
+    }
+
+    // cho den khi co ban tin roi lay mot lo toi da max ban tin; ban tin la khung nhin len
+    // khoi da nhan tu socket, khoi tro ve pool khi Buffer bi huy (vi du out.clear())
+    size_t getMessages(std::vector<Buffer>& out, size_t max) {
+        return inbox.popMany(out, max);
+    }
+
+    BufferStats getBufferStats() const {
+        return pool.getStats();
+    }
+
+    InboxStats getInboxStats() const {
+        return inbox.getStats();
+    }
+
+    LaneStats getLaneStats(Priority priority) const {
+        size_t lane = static_cast<size_t>(priority);
+        return LaneStats{inbox.getStats(lane), outbox ? outbox->getStats(lane) : OutboxStats{0, 0, 0, 0, 0, 0, 0}};
+    }
+
+    CommStats getStats() const {
+        CommStats stats = transport->getStats();
+        if (outbox) {
+            OutboxStats queue = outbox->getStats();
+            stats.queuedSends = queue.queued;
+            stats.queueDrops = queue.dropped;
+            stats.queueDepth = queue.depth;
+            stats.queueHighWater = queue.highWater;
+        }
+        stats.corruptFrames = corruptFrames.load();
+        stats.inboxDrops = inboxDrops.load();
+        return stats;
+    }
+
+    // thong ke cua mot peer: phan Comm dem (ban tin, byte, do tre tu FrameStamp) cong voi
+    // hang doi gui cua peer va so lan ket noi that bai cua transport
+    PeerStats getPeerStats(int peerId) const {
+        PeerStats stats = metrics.snapshot(peerId);
+        if (outbox) {
+            OutboxPeerStats queue = outbox->getPeerStats(peerId);
+            stats.queueDepth = queue.depth;
+            stats.queueDrops = queue.dropped;
+        }
+        stats.connectFailures = transport->connectFailures(peerId);
+        return stats;
+    }
+
+    std::vector<PeerStats> getAllPeerStats() const {
+        std::vector<PeerStats> all;
+        for (int i = 1; i <= config.getTotalNodes(); i++) {
+            if (i != id) {
+                all.push_back(getPeerStats(i));
+            }
+        }
+        return all;
+    }
+
+    // tong hop cho log / cong cu doc thong ke
+    json getStatsJson() const {
+        CommStats stats = getStats();
+        json out;
+        out["transport"] = getTransportName();
+        out["messagesSent"] = stats.messagesSent;
+        out["messagesReceived"] = stats.messagesReceived;
+        out["connects"] = stats.connects;
+        out["reconnects"] = stats.reconnects;
+        out["deliveryFailures"] = stats.deliveryFailures;
+        out["queueDrops"] = stats.queueDrops;
+        out["queueDepth"] = stats.queueDepth;
+        out["corruptFrames"] = stats.corruptFrames;
+        out["inboxDrops"] = stats.inboxDrops;
+        out["peers"] = json::array();
+        for (const PeerStats &peer : getAllPeerStats()) {
+            out["peers"].push_back(peer.toJson());
+        }
+        return out;
+    }
+
+    // handler(peer, so ban tin) duoc goi khi ban tin toi peer bi bo sau khi het so lan
+    // truyen lai (RELIABLE=1 hoac TRANSPORT=udp); chay tren luong I/O, khong duoc chan lau
+    void onDeliveryFailure(std::function<void(int, size_t)> handler) {
+        transport->onFailure(handler);
+    }
+
+    ReorderStats getReorderStats() const {
+        return reorder ? reorder->getStats() : ReorderStats{0, 0, 0, 0, 0, 0, 0};
+    }
+
+    std::string getTransportName() const {
+        return transport->name();
+    }
+
+    std::string getPeerTransport(int peerId) const {
+        return transport->peerTransport(peerId);
+    }
+
+private:
+    void checkNetworkError() {
         if (error.simulateNetworkError()) {
             time_t now = time(0);
             tm *ltm = localtime(&now);
@@ -78,74 +338,112 @@ public:
             std::cout << "node " << id << " died at " + std::string(buffer) << "\n";
             exit(EXIT_FAILURE);
         }
-        // else if (error.simulateMessageLoss()) {
-        //     return;
-        // }
-        // else if (error.simulateMessageDelay()) {
-        //     std::this_thread::sleep_for(std::chrono::seconds(1));
-        // }
+    }
 
-        auto it = config.getNodeConfigs().find(destId);
-        // if (it == config.getNodeConfigs().end()) {
-        //     std::cout << "Destination ID " << destId << " not found";
-        //     // return;
-        //     throw std::runtime_error("Destination ID " + std::to_string(destId) + " not found");
-        // }
-        int clientSocket = socket(AF_INET, SOCK_STREAM, 0);
-        if (clientSocket < 0) {
-            close(clientSocket);
-            return;
+    // lop uu tien doc tu byte type cua ban tin nhi phan, khong can giai ma;
+    // ban tin khong dung dinh dang di lan NORMAL
+    size_t laneOf(std::string_view message) const {
+        if (message.size() < Message::HEADER_SIZE || static_cast<uint8_t>(message[0]) != Message::WIRE_VERSION) {
+            return static_cast<size_t>(Priority::NORMAL);
         }
-        sockaddr_in destIp;
-        destIp.sin_family = AF_INET;
-        destIp.sin_port = htons(it->second.second);
-        inet_pton(AF_INET, it->second.first.c_str(), &destIp.sin_addr);
-        if (connect(clientSocket, (struct sockaddr*)&destIp, sizeof(destIp)) < 0) {
-            close(clientSocket);
-            return;
+        uint8_t type = static_cast<uint8_t>(message[1]);
+        if (type > static_cast<uint8_t>(MsgType::LAST)) {
+            return static_cast<size_t>(Priority::NORMAL);
         }
-        if (::send(clientSocket, message.c_str(), message.size(), 0) < 0) {
-            close(clientSocket);
-            return;
+        return static_cast<size_t>(classes[type].load(std::memory_order_relaxed));
+    }
+
+    // them FrameStamp va duoi CRC32C; khi co phong bi seq thi de transmit niem phong ca phong bi
+    std::string frame(const std::string &message) const {
+        std::string sealed;
+        sealed.reserve(message.size() + FrameStamp::SIZE + FrameChecksum::SIZE);
+        sealed = message;
+        FrameStamp::append(sealed, static_cast<uint32_t>(id), FrameStamp::now());
+        if (!reorder) {
+            FrameChecksum::seal(sealed);
         }
-        close(clientSocket);
+        return sealed;
     }
 
-    int getMessage(std::string& msg) {
-        std::unique_lock<std::mutex> lock(socketMutex);
-        messageAvailable.wait(lock, [this]{ return !messageQueue.empty(); });
-        
-        if (messageQueue.empty()) {
-            return 0; 
-        }
-        msg = messageQueue.front();
-        messageQueue.pop();
-        return 1;
+    // chay tren luong I/O cua dich (Outbox): danh so roi gui; seq chi tang khi gui duoc
+    // nen ban tin gui loi khong de lai cho trong ben nhan
+    bool transmit(int destId, const std::string &message) {
+        if (!reorder) {
+            bool ok = transport->send(destId, message);
+            metrics.sent(destId, message.size(), ok);
+            return ok;
+        }
+        if (destId <= 0 || destId >= static_cast<int>(nextSeq.size())) {
+            return false;
+        }
+        SequenceHeader header{static_cast<uint32_t>(id), session, nextSeq[destId]};
+        std::string sealed = header.wrap(message);
+        FrameChecksum::seal(sealed);
+        bool ok = transport->send(destId, sealed);
+        metrics.sent(destId, sealed.size(), ok);
+        if (!ok) {
+            return false;
+        }
+        nextSeq[destId]++;
+        return true;
     }
 
-private:
-    void receiveThread() {  
-        while (1) {
-            int clientSocket = accept(serverSocket, nullptr, nullptr);
-            if (clientSocket >= 0) {
-                char buffer[1024] = {0};
-                int bytesRead = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
-                if (bytesRead < 0) {
-                    close(clientSocket);
-                    throw std::runtime_error("Failed to receive message");
-                }
-                else {
-                    buffer[bytesRead] = '\0';
-                    {
-                        std::lock_guard<std::mutex> lock(socketMutex);
-                        messageQueue.emplace(std::string(buffer));
-                    }
-                    messageAvailable.notify_one();
+    // ReorderBuffer chi xet timeout khi nguon gui ban tin moi; nguon im lang sau mot cho
+    // trong thi ban tin dang giu (co the la TOKEN) duoc giao o day
+    void timerThread() {
+        typedef std::chrono::steady_clock Clock;
+        std::chrono::milliseconds statsInterval(config.getStatsIntervalMs());
+        std::chrono::milliseconds sweep = std::max(std::chrono::milliseconds(1),
+                                                   std::chrono::milliseconds(config.getReorderTimeoutMs() / 2));
+        std::chrono::milliseconds tick = !reorder ? statsInterval
+                                       : statsInterval.count() > 0 ? std::min(statsInterval, sweep) : sweep;
+        Clock::time_point nextStats = Clock::now() + statsInterval;
+        std::unique_lock<std::mutex> lock(timerMutex);
+        while (!timerCond.wait_for(lock, tick, [this]() { return stopping; })) {
+            if (reorder) {
+                reorder->expire([this](Buffer &&ready) {
+                    size_t lane = laneOf(ready.view());
+                    inbox.push(std::move(ready), lane);
+                });
+            }
+            if (statsInterval.count() > 0 && Clock::now() >= nextStats) {
+                nextStats += statsInterval;
+                if (logger != nullptr) {
+                    logger->log(LogCategory::STATS, id, [this](json &note) {
+                        note = getStatsJson();
+                        return "transport";
+                    });
                 }
-                close(clientSocket);
             }
-            else {
-                throw std::runtime_error("Error accepting connection");
+        }
+    }
+
+    // frame hong (ke ca do ErrorSimulator gia lap) bi dem va bo, khong toi processMessage
+    void deliver(std::vector<Buffer> &messages) {
+        for (auto &m : messages) {
+            error.simulateMessageModified(m, pool);
+            size_t bytes = m.size();
+            uint32_t source = 0;
+            uint64_t sentNs = 0;
+            if (!FrameChecksum::verify(m) || !FrameStamp::strip(m, source, sentNs)) {
+                corruptFrames++;
+                continue;
+            }
+            metrics.received(static_cast<int>(source), bytes, sentNs, FrameStamp::now());
+            if (reorder) {
+                reorder->receive(std::move(m), [this](Buffer &&ready) {
+                    size_t lane = laneOf(ready.view());
+                    inbox.push(std::move(ready), lane);
+                });
+            } else if (dropWhenFull) {
+                // m con lai trong lo de transport biet ban tin bi bo
+                size_t lane = laneOf(m.view());
+                if (!inbox.tryPush(std::move(m), lane)) {
+                    inboxDrops++;
+                }
+            } else {
+                size_t lane = laneOf(m.view());
+                inbox.push(std::move(m), lane);
             }
         }
     }
@@ -3,13 +3,44 @@
 #define CONFIG_H
 
 #include "dotenv.h"
+#include "peers.h"
 #include <map>
+#include <memory>
+#include <algorithm>
 
 class Config {
 private:
     int totalNodes;
     std::string brokerAddress;
+    std::string transport;      // cach truyen tin cua Comm: socket / uring / udp / shm
+    size_t inboxCapacity;       // so ban tin toi da trong hop thu den cua moi node
+    size_t ioWorkers;           // so luong gui song song cua Comm
+    size_t receiveWorkers;      // so luong nhan cua transport socket, moi luong mot socket lang nghe SO_REUSEPORT
+    size_t sendQueueLimit;      // so ban tin toi da cho gui toi moi peer
+    int connectTimeoutMs;       // thoi gian toi da cho connect / mot lan ghi toi peer
+    size_t reorderWindow;       // so ban tin den som toi da duoc giu cho moi nguon
+    int reorderTimeoutMs;       // thoi gian toi da cho ban tin bi thieu
+    bool reliable;              // bao nhan + truyen lai cho socket / uring
+    int reliableRetries;        // so lan truyen lai truoc khi bao peer khong toi duoc
+    int reliableMaxRtoMs;       // thoi gian cho toi da giua hai lan truyen lai
+    int statsIntervalMs;        // chu ky ghi thong ke transport theo peer vao log, 0 = tat
+    std::string logLevel;       // debug / info / warn / error / off
+    std::string logCategories;  // all hoac danh sach: send,receive,notice,error,stats
+    std::string logBackend;     // ring: moi luong ghi mot ring, mot luong doc ghi ra sink; direct: ghi tren luong goi
+    size_t logRingCapacity;     // so o (128 byte) trong ring cua moi luong ghi log
+    std::string logRingPolicy;  // ring day: block (cho) hoac drop (bo, co dem)
+    std::string logFile;        // file log cua moi node, {id} thay bang id cua logger
+    std::string logFormat;      // json: dong JSON; binary: logformat.h, doc bang logconvert
+    std::string logFlush;       // none / interval / count / fsync (xem FileLoggingMethod)
+    int logFlushIntervalMs;
+    size_t logFlushCount;
+    std::string mqttTopic;      // log cua node id gui len topic <mqttTopic>/<id>
+    int mqttQos;
+    size_t mqttWindow;          // so ban tin MQTT toi da dang cho broker xac nhan
+    size_t mqttBatch;           // so ban ghi toi da trong mot ban tin MQTT
+    size_t mqttQueueLimit;      // so ban ghi toi da cho gui, vuot qua thi bo
     std::map<int, std::pair<std::string, int>> nodeConfigs; // cau hinh cho tung nut: id - ip - port
+    std::shared_ptr<const PeerTable> peerTable;     // dia chi da phan giai, chi doc/ghi qua std::atomic_load/atomic_store
 
 public:
     Config() {
@@ -26,24 +57,149 @@ public:
     }
 
     std::string getAddress(int nodeId) const {
-        auto it = nodeConfigs.find(nodeId);
-        if (it != nodeConfigs.end()) {
-            return it->second.first;
+        std::shared_ptr<const PeerTable> table = getPeers();
+        const PeerAddress *peer = table->find(nodeId);
+        if (peer != nullptr) {
+            return peer->ip;
         }
         throw std::runtime_error("Node " + std::to_string(nodeId) + " not found");
     }
 
     int getPort(int nodeId) const {
-        auto it = nodeConfigs.find(nodeId);
-        if (it != nodeConfigs.end()) {
-            return it->second.second;
+        std::shared_ptr<const PeerTable> table = getPeers();
+        const PeerAddress *peer = table->find(nodeId);
+        if (peer != nullptr) {
+            return peer->port;
         }
         throw std::runtime_error("Node " + std::to_string(nodeId) + " not found");
     }
 
-    std::map<int, std::pair<std::string, int>> getNodeConfigs() { 
+    std::string getTransport() const {
+        return transport;
+    }
+
+    size_t getInboxCapacity() const {
+        return inboxCapacity;
+    }
+
+    size_t getIoWorkers() const {
+        return ioWorkers;
+    }
+
+    size_t getReceiveWorkers() const {
+        return receiveWorkers;
+    }
+
+    size_t getSendQueueLimit() const {
+        return sendQueueLimit;
+    }
+
+    int getConnectTimeoutMs() const {
+        return connectTimeoutMs;
+    }
+
+    size_t getReorderWindow() const {
+        return reorderWindow;
+    }
+
+    int getReorderTimeoutMs() const {
+        return reorderTimeoutMs;
+    }
+
+    bool isReliable() const {
+        return reliable;
+    }
+
+    int getReliableRetries() const {
+        return reliableRetries;
+    }
+
+    int getReliableMaxRtoMs() const {
+        return reliableMaxRtoMs;
+    }
+
+    int getStatsIntervalMs() const {
+        return statsIntervalMs;
+    }
+
+    std::string getLogLevel() const {
+        return logLevel;
+    }
+
+    std::string getLogCategories() const {
+        return logCategories;
+    }
+
+    std::string getLogBackend() const {
+        return logBackend;
+    }
+
+    size_t getLogRingCapacity() const {
+        return logRingCapacity;
+    }
+
+    std::string getLogRingPolicy() const {
+        return logRingPolicy;
+    }
+
+    std::string getLogFile() const {
+        return logFile;
+    }
+
+    std::string getLogFormat() const {
+        return logFormat;
+    }
+
+    std::string getLogFlush() const {
+        return logFlush;
+    }
+
+    int getLogFlushIntervalMs() const {
+        return logFlushIntervalMs;
+    }
+
+    size_t getLogFlushCount() const {
+        return logFlushCount;
+    }
+
+    std::string getMqttTopic() const {
+        return mqttTopic;
+    }
+
+    int getMqttQos() const {
+        return mqttQos;
+    }
+
+    size_t getMqttWindow() const {
+        return mqttWindow;
+    }
+
+    size_t getMqttBatch() const {
+        return mqttBatch;
+    }
+
+    size_t getMqttQueueLimit() const {
+        return mqttQueueLimit;
+    }
+
+    // cau hinh doc tu config.env luc khoi dong
+    const std::map<int, std::pair<std::string, int>> &getNodeConfigs() const { 
         return nodeConfigs;
     }
+
+    // anh chup bang dia chi hien tai: moi lan gui/connect lay mot lan va giu trong luc dung,
+    // bang cu duoc giai phong khi nguoi doc cuoi cung buong no
+    std::shared_ptr<const PeerTable> getPeers() const {
+        return std::atomic_load(&peerTable);
+    }
+
+    // doi dia chi cac node (vd node chuyen sang may khac) khi dang chay: ket noi moi dung dia
+    // chi moi, ket noi dang mo giu nguyen toi khi dut. Transport cap phat trang thai theo peer
+    // tu bang luc khoi dong nen id nam ngoai pham vi do bi bo qua cho toi khi khoi dong lai
+    void updatePeers(const std::map<int, std::pair<std::string, int>> &nodes) {
+        std::shared_ptr<const PeerTable> table = std::make_shared<const PeerTable>(nodes);
+        std::atomic_store(&peerTable, table);
+    }
     
 private:
     void loadConfigurations() { // load file config.env
@@ -53,15 +209,46 @@ private:
                 throw std::runtime_error("TOTAL_NODES must be greater than 0\n");
             }
             brokerAddress = dotenv::getenv("BROKER_ADDRESS_MQTT", "tcp://localhost:1883");
+            transport = dotenv::getenv("TRANSPORT", "socket");
+            inboxCapacity = std::stoul(dotenv::getenv("INBOX_CAPACITY", "4096"));
+            ioWorkers = std::stoul(dotenv::getenv("IO_WORKERS", "4"));
+            receiveWorkers = std::max<size_t>(1, std::stoul(dotenv::getenv("RECEIVE_WORKERS", "1")));
+            sendQueueLimit = std::stoul(dotenv::getenv("SEND_QUEUE_LIMIT", "4096"));
+            connectTimeoutMs = std::max(1, std::stoi(dotenv::getenv("CONNECT_TIMEOUT_MS", "200")));
+            reorderWindow = std::stoul(dotenv::getenv("REORDER_WINDOW", "64"));
+            reorderTimeoutMs = std::stoi(dotenv::getenv("REORDER_TIMEOUT_MS", "200"));
+            reliable = dotenv::getenv("RELIABLE", "0") == "1";
+            reliableRetries = std::stoi(dotenv::getenv("RELIABLE_RETRIES", "5"));
+            reliableMaxRtoMs = std::stoi(dotenv::getenv("RELIABLE_MAX_RTO_MS", "400"));
+            statsIntervalMs = std::stoi(dotenv::getenv("STATS_INTERVAL_MS", "0"));
+            logLevel = dotenv::getenv("LOG_LEVEL", "debug");
+            logCategories = dotenv::getenv("LOG_CATEGORIES", "all");
+            logBackend = dotenv::getenv("LOG_BACKEND", "ring");
+            logRingCapacity = std::stoul(dotenv::getenv("LOG_RING_CAPACITY", "1024"));
+            logRingPolicy = dotenv::getenv("LOG_RING_POLICY", "block");
+            logFile = dotenv::getenv("LOG_FILE", "log_{id}.txt");
+            logFormat = dotenv::getenv("LOG_FORMAT", "json");
+            logFlush = dotenv::getenv("LOG_FLUSH", "interval");
+            logFlushIntervalMs = std::stoi(dotenv::getenv("LOG_FLUSH_INTERVAL_MS", "100"));
+            logFlushCount = std::stoul(dotenv::getenv("LOG_FLUSH_COUNT", "256"));
+            mqttTopic = dotenv::getenv("MQTT_TOPIC", "test_dme");
+            mqttQos = std::stoi(dotenv::getenv("MQTT_QOS", "1"));
+            mqttWindow = std::stoul(dotenv::getenv("MQTT_WINDOW", "16"));
+            mqttBatch = std::stoul(dotenv::getenv("MQTT_BATCH", "64"));
+            mqttQueueLimit = std::stoul(dotenv::getenv("MQTT_QUEUE_LIMIT", "65536"));
+            // transport shm chay moi node trong mot tien trinh nen khong can dia chi cho tung node
+            std::string defaultIp = (transport == "shm") ? "127.0.0.1" : "";
             for (int i = 1; i <= totalNodes; i++) {
-                std::string ip = dotenv::getenv(("NODE_" + std::to_string(i) + "_IP").c_str());
-                int port = std::stoi(dotenv::getenv(("NODE_" + std::to_string(i) + "_PORT").c_str()));
+                std::string ip = dotenv::getenv(("NODE_" + std::to_string(i) + "_IP").c_str(), defaultIp);
+                std::string defaultPort = (transport == "shm") ? std::to_string(8080 + i) : "";
+                int port = std::stoi(dotenv::getenv(("NODE_" + std::to_string(i) + "_PORT").c_str(), defaultPort));
                 if (ip.empty() || port <= 0 || port > 65535) {
                     throw std::runtime_error("Invalid address or port for node " + std::to_string(i) + "\n");
                 }
 
                 nodeConfigs[i] = std::make_pair(ip, port);
             }
+            updatePeers(nodeConfigs);
         }
         catch (const std::exception &e) {
             std::cerr << "Configuration error: " << e.what() << std::endl;
@@ -0,0 +1,96 @@
+// dispatch.h
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "codec.h"
+#include <array>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <initializer_list>
+
+struct DispatchStats {
+    uint64_t handled;           // so ban tin da chuyen cho handler
+    uint64_t unknown;           // type hop le ve dinh dang nhung thuat toan khong dang ky
+    uint64_t malformed;         // khong giai ma duoc (sai phien ban, sai do dai...)
+};
+
+// Bang dieu phoi ban tin cua mot thuat toan: moi MsgType duoc gan mot handler mot lan
+// khi tao node. dispatch giai ma ban tin roi nhay thang toi handler theo chi so type,
+// thay cho chuoi so sanh chuoi. Ban tin la hoac hong duoc dem lai. Moi route khai bao
+// them lop uu tien cua type (mac dinh NORMAL), thuat toan dang ky bang nay voi Comm.
+//
+//   Dispatcher<Lamport> dispatcher{*this, {
+//       {MsgType::OK, [](Lamport &self, const Message &m) { self.receivedAgree(m.source, m.timestamp); }},
+//   }};
+//   Dispatcher<TokenRing> dispatcher{*this, {
+//       {MsgType::TOKEN, [](TokenRing &self, const Message &m) { self.receivedToken(m.source); }, Priority::CONTROL},
+//   }};
+template <typename Owner>
+class Dispatcher {
+public:
+    typedef void (*Handler)(Owner &, const Message &);
+
+    struct Route {
+        MsgType type;
+        Handler handler;
+        Priority priority = Priority::NORMAL;
+    };
+
+private:
+    static const size_t TABLE_SIZE = static_cast<size_t>(MsgType::LAST) + 1;
+
+    Owner &owner;
+    std::array<Handler, TABLE_SIZE> table{};
+    PriorityTable classes;
+    std::atomic<uint64_t> handled{0};
+    std::atomic<uint64_t> unknown{0};
+    std::atomic<uint64_t> malformed{0};
+
+public:
+    Dispatcher(Owner &owner, std::initializer_list<Route> routes) : owner(owner) {
+        classes.fill(Priority::NORMAL);
+        for (const Route &route : routes) {
+            size_t index = static_cast<size_t>(route.type);
+            if (table[index] != nullptr) {
+                throw std::runtime_error(std::string("Duplicate handler for ") + msgTypeName(route.type));
+            }
+            table[index] = route.handler;
+            classes[index] = route.priority;
+        }
+    }
+
+    // data: ban tin nhan duoc, thuong la Buffer::view() - khong chep
+    void dispatch(std::string_view data) {
+        Message message;
+        if (!message.decode(data.data(), data.size())) {
+            // header dung phien ban nhung type nam ngoai bang: ban tin cua phien ban khac
+            bool knownHeader = data.size() >= Message::HEADER_SIZE &&
+                               static_cast<uint8_t>(data[0]) == Message::WIRE_VERSION;
+            if (knownHeader && (data[1] == 0 || static_cast<uint8_t>(data[1]) > static_cast<uint8_t>(MsgType::LAST))) {
+                unknown.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                malformed.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        Handler handler = table[static_cast<size_t>(message.type)];
+        if (handler == nullptr) {
+            unknown.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        handled.fetch_add(1, std::memory_order_relaxed);
+        handler(owner, message);
+    }
+
+    const PriorityTable &priorities() const {
+        return classes;
+    }
+
+    DispatchStats getStats() const {
+        return DispatchStats{handled.load(), unknown.load(), malformed.load()};
+    }
+};
+
+#endif // DISPATCH_H
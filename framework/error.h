@@ -3,11 +3,13 @@
 #define ERROR_H
 
 #include "log.h"
+#include "buffer.h"
 #include <random>
 #include <string>
 #include <chrono>
 #include <thread>
 #include <map>
+#include <mutex>
 
 
 enum ErrorType {
@@ -22,6 +24,7 @@ private:
     std::random_device rd;
     std::mt19937 gen;
     std::map<ErrorType, double> errorProbabilities;
+    std::mutex mtx;                   // nhieu node co the dung chung mot ErrorSimulator
     bool isDisconnected = false;      // Trạng thái mất mạng
     bool isSpoofing = false;          // Trạng thái giả mạo
 
@@ -37,11 +40,16 @@ public:
 
     // Đặt xác suất cho một loại lỗi
     void setErrorProbability(ErrorType errorType, double probability) {
+        std::lock_guard<std::mutex> lock(mtx);
         errorProbabilities[errorType] = probability;
     }
 
     // Sinh lỗi ngẫu nhiên dựa trên xác suất
     bool triggerError(ErrorType errorType) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (errorProbabilities[errorType] <= 0) {
+            return false;
+        }
         std::uniform_real_distribution<> dis(0.0, 1.0);
         return dis(gen) < errorProbabilities[errorType];
     }
@@ -82,7 +90,15 @@ public:
         return false;
     }
 
-    
+    // ban tin nhan duoc nam trong buffer chi doc: chep ra ban da sua vao khoi moi cua pool
+    bool simulateMessageModified(Buffer &message, BufferPool &pool) {
+        if (triggerError(MESSAGE_MODIFIED)) {
+            std::string modified = message.str() + "(Modified)";
+            message = pool.copy(modified);
+            return true;
+        }
+        return false;
+    }
 };
 
 #endif // ERROR_H
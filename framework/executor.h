@@ -0,0 +1,85 @@
+// executor.h
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+// Nhom luong I/O gui ban tin. Cong viec cung key (id node dich) luon chay tren cung
+// mot luong theo thu tu da dua vao, nen thu tu FIFO toi moi dich duoc giu nguyen
+// trong khi cac dich khac nhau duoc gui song song.
+class IoWorkers {
+private:
+    struct Worker {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> tasks;
+        bool stopping = false;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+public:
+    explicit IoWorkers(size_t count) {
+        for (size_t i = 0; i < std::max<size_t>(count, 1); i++) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (auto &w : workers) {
+            w->thread = std::thread(&IoWorkers::run, w.get());
+        }
+    }
+
+    ~IoWorkers() {
+        for (auto &w : workers) {
+            {
+                std::lock_guard<std::mutex> lock(w->mtx);
+                w->stopping = true;
+            }
+            w->cv.notify_one();
+        }
+        for (auto &w : workers) {
+            if (w->thread.joinable()) {
+                w->thread.join();
+            }
+        }
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    void post(int key, std::function<void()> task) {
+        Worker &w = *workers[static_cast<size_t>(key) % workers.size()];
+        {
+            std::lock_guard<std::mutex> lock(w.mtx);
+            w.tasks.push_back(std::move(task));
+        }
+        w.cv.notify_one();
+    }
+
+private:
+    // chay het cong viec con lai truoc khi dung
+    static void run(Worker *w) {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(w->mtx);
+                w->cv.wait(lock, [w]() { return w->stopping || !w->tasks.empty(); });
+                if (w->tasks.empty()) {
+                    return;
+                }
+                task = std::move(w->tasks.front());
+                w->tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+#endif // EXECUTOR_H
@@ -4,13 +4,93 @@
 
 #include <iostream>
 #include <list>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <sstream>
 #include <nlohmann/json.hpp>
 #include "mqtt/async_client.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "config.h"
+#include "logring.h"
+#include "logformat.h"
 
 typedef nlohmann::ordered_json json;
 
+// muc do log; ban ghi duoc ghi khi muc cua loai >= muc nguong (LOG_LEVEL)
+enum class LogLevel : uint8_t {
+    DEBUG = 0,
+    INFO,
+    WARN,
+    ERROR,
+    OFF,
+};
+
+// loai ban ghi, trung voi truong "type" ma UI doc
+enum class LogCategory : uint8_t {
+    SEND = 0,
+    RECEIVE,
+    NOTICE,
+    ERROR,
+    STATS,
+    COUNT,
+};
+
+inline const char *logCategoryName(LogCategory category) {
+    static const char *names[] = {"send", "receive", "notice", "error", "stats"};
+    return names[static_cast<size_t>(category)];
+}
+
+// send / receive la tung buoc cua giao thuc (DEBUG); notice, stats la su kien (INFO)
+inline LogLevel logCategoryLevel(LogCategory category) {
+    static const LogLevel levels[] = {LogLevel::DEBUG, LogLevel::DEBUG, LogLevel::INFO, LogLevel::ERROR, LogLevel::INFO};
+    return levels[static_cast<size_t>(category)];
+}
+
+// loai khong biet (vi du loi chinh ta o call site cu) coi nhu notice
+inline LogCategory parseLogCategory(const std::string &name) {
+    for (size_t i = 0; i < static_cast<size_t>(LogCategory::COUNT); i++) {
+        if (name == logCategoryName(static_cast<LogCategory>(i))) {
+            return static_cast<LogCategory>(i);
+        }
+    }
+    if (name == "received" || name == "recieve") {
+        return LogCategory::RECEIVE;
+    }
+    return LogCategory::NOTICE;
+}
+
+inline LogLevel parseLogLevel(const std::string &name) {
+    static const char *names[] = {"debug", "info", "warn", "error", "off"};
+    for (size_t i = 0; i < 5; i++) {
+        if (name == names[i]) {
+            return static_cast<LogLevel>(i);
+        }
+    }
+    throw std::runtime_error("Unknown log level " + name + "\n");
+}
+
+// "all" hoac danh sach cach nhau boi dau phay, vi du "notice,error"
+inline uint32_t parseLogCategories(const std::string &list) {
+    if (list == "all") {
+        return (1u << static_cast<size_t>(LogCategory::COUNT)) - 1;
+    }
+    uint32_t mask = 0;
+    std::stringstream ss(list);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        if (!name.empty()) {
+            mask |= 1u << static_cast<size_t>(parseLogCategory(name));
+        }
+    }
+    return mask;
+}
+
 
 class LoggingMethod {
 public:
@@ -18,6 +98,16 @@ public:
     virtual void init() {}
     virtual void clean() {}
     virtual void log(int id, const std::string &logData) = 0;
+    // false khi sink khong ghi duoc (vi du khong mo duoc file): khong dung ban ghi cho no
+    virtual bool ready() const {
+        return true;
+    }
+    // sink nhan ban ghi nhi phan (logformat.h) khi LOG_FORMAT=binary thay vi dong JSON
+    virtual bool binary() const {
+        return false;
+    }
+    // timeUs tinh tu luc Logger khoi tao, note da ma hoa bang BinaryLog::encodeNote
+    virtual void logBinary(uint64_t, const std::string &, int, const std::string &, const std::string &) {}
 };
 
 class ConsoleLoggingMethod : public LoggingMethod {
@@ -31,38 +121,130 @@ public:
     }
 };
 
+struct FileLogStats {
+    uint64_t records;
+    uint64_t bytesWritten;
+    uint64_t writeCalls;        // so lan goi write()
+    uint64_t flushes;           // so lan day mot lo xuong file (kem fdatasync neu LOG_FLUSH=fsync)
+    uint64_t totalFlushNs;
+    uint64_t maxFlushNs;
+
+    double averageFlushUs() const {
+        return flushes == 0 ? 0.0 : totalFlushNs / 1000.0 / flushes;
+    }
+};
+
+// Ghi log ra file rieng cua node (LOG_FILE, {id} thay bang id cua logger) theo kieu group
+// commit: luong goi log chi noi ban ghi vao bo dem chung, luong ghi doi bo dem roi ghi ca lo
+// bang mot lan write(). LOG_FORMAT=binary ghi dinh dang logformat.h thay cho dong JSON.
+// Khi flush:
+//   none      ghi khi bo dem du BUFFER_SIZE, chi ghi phan chan ALIGN byte, phan con lai ghi khi dong
+//   interval  ghi het moi LOG_FLUSH_INTERVAL_MS
+//   count     ghi het sau moi LOG_FLUSH_COUNT ban ghi
+//   fsync     ghi het va fdatasync moi lo; ban ghi den trong luc fsync vao lo sau
 class FileLoggingMethod : public LoggingMethod {
+public:
+    enum class Flush {
+        NONE,
+        INTERVAL,
+        COUNT,
+        FSYNC,
+    };
+
+    static const size_t BUFFER_SIZE = 64 * 1024;
+    static const size_t ALIGN = 4096;
+
 protected:
-    std::ofstream file;
-    std::queue<std::string> queue;
+    int id;
+    std::string path;
+    std::string timeInit;
+    bool binaryFormat;
+    BinaryLog::Writer writer;       // trang thai delta thoi gian, bao ve boi fileMutex
+    Flush flush;
+    std::chrono::milliseconds interval;
+    size_t flushCount;
+    int fd = -1;
+    std::string pending;            // ban ghi cho ghi, bao ve boi fileMutex
+    size_t pendingRecords = 0;
+    bool writerWaiting = false;
     bool closed = false;
     std::mutex fileMutex;
     std::condition_variable cond;
     std::thread m_logFileThread;
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint64_t> writeCalls{0};
+    std::atomic<uint64_t> flushes{0};
+    std::atomic<uint64_t> totalFlushNs{0};
+    std::atomic<uint64_t> maxFlushNs{0};
 
 public:
+    FileLoggingMethod(int id, const std::string &timeInit)
+        : id(id), path(filePath(config.getLogFile(), id)), timeInit(timeInit), binaryFormat(config.getLogFormat() == "binary"),
+          flush(parseFlush(config.getLogFlush())),
+          interval(config.getLogFlushIntervalMs()), flushCount(std::max<size_t>(1, config.getLogFlushCount())) {}
+
+    static std::string filePath(std::string pattern, int id) {
+        size_t pos = pattern.find("{id}");
+        if (pos != std::string::npos) {
+            pattern.replace(pos, 4, std::to_string(id));
+        }
+        return pattern;
+    }
+
+    static Flush parseFlush(const std::string &name) {
+        if (name == "none") return Flush::NONE;
+        if (name == "interval") return Flush::INTERVAL;
+        if (name == "count") return Flush::COUNT;
+        if (name == "fsync") return Flush::FSYNC;
+        throw std::runtime_error("Unknown log flush policy " + name + "\n");
+    }
+
     void init() override {
         LoggingMethod::init();
-        if (file.is_open()) file.close();
-        file.open("log.txt", std::ios::out | std::ios::app);
-        if (!file) {
-            std::cout << "Failed to create file log\n" << std::endl;
+        clean();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cout << "Failed to create file log " << path << "\n" << std::endl;
             return;
         }
+        closed = false;
+        if (binaryFormat) {
+            // moi lan mo la mot phien moi, noi tiep vao file cu
+            std::lock_guard<std::mutex> lock(fileMutex);
+            writer.session(pending, id, timeInit);
+        }
         m_logFileThread = std::thread(&FileLoggingMethod::logFileThread, this);
     }
 
     void logFileThread() {
-        do {
-            std::unique_lock lock(fileMutex);
-            cond.wait(lock, [this]() { return !queue.empty() || closed; });
-            while (!queue.empty()) {
-                auto& s = queue.front();
-                file.seekp(0, std::ios::end);
-                file << s << "\n";
-                queue.pop();
+        std::string batch;
+        std::unique_lock<std::mutex> lock(fileMutex);
+        while (true) {
+            writerWaiting = true;
+            if (flush == Flush::INTERVAL) {
+                cond.wait_for(lock, interval, [this]() { return closed || due(); });
+            } else {
+                cond.wait(lock, [this]() { return closed || due(); });
+            }
+            writerWaiting = false;
+            bool last = closed;
+            size_t size = pending.size();
+            if (flush == Flush::NONE && !last) {
+                size -= size % ALIGN;
+            }
+            if (size > 0) {
+                batch.assign(pending, 0, size);
+                pending.erase(0, size);
+                pendingRecords = 0;
+                lock.unlock();
+                writeBatch(batch);
+                lock.lock();
             }
-        } while (!closed);
+            if (last) {
+                break;
+            }
+        }
     }
 
     ~FileLoggingMethod() {
@@ -71,43 +253,237 @@ public:
 
     void clean() override {
         {
-            closed = true;
             std::unique_lock<std::mutex> lock(fileMutex);
+            closed = true;
         }
         cond.notify_one();
         if (m_logFileThread.joinable()) {
             m_logFileThread.join();
         }
-        if (file.is_open()) {
-            file.close();
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
         }
     }
 
+    bool ready() const override {
+        return fd >= 0;
+    }
+
     void log(int id, const std::string &logData) override {
-        if (!file.is_open()) return;
+        if (fd < 0) return;
         std::unique_lock lock(fileMutex);
-        queue.push(logData);
-        cond.notify_one();
+        pending += logData;
+        pending += '\n';
+        appended(lock);
+    }
+
+    bool binary() const override {
+        return binaryFormat;
+    }
+
+    // note nhi phan duoc chep thang vao bo dem, khong dung lai JSON
+    void logBinary(uint64_t timeUs, const std::string &type, int id, const std::string &content,
+                   const std::string &note) override {
+        if (fd < 0) return;
+        std::unique_lock lock(fileMutex);
+        writer.append(pending, timeUs, type, id, content, note);
+        appended(lock);
+    }
+
+    FileLogStats getStats() const {
+        return FileLogStats{records.load(), bytesWritten.load(), writeCalls.load(), flushes.load(),
+                            totalFlushNs.load(), maxFlushNs.load()};
+    }
+
+private:
+    // chi bao luong ghi khi lo da den han va no dang cho, khong phai moi ban ghi
+    void appended(std::unique_lock<std::mutex> &lock) {
+        pendingRecords++;
+        records.fetch_add(1, std::memory_order_relaxed);
+        if (writerWaiting && due()) {
+            writerWaiting = false;
+            lock.unlock();
+            cond.notify_one();
+        }
+    }
+
+    // goi khi dang giu fileMutex
+    bool due() const {
+        switch (flush) {
+            case Flush::NONE:
+            case Flush::INTERVAL: return pending.size() >= BUFFER_SIZE;
+            case Flush::COUNT: return pendingRecords >= flushCount || pending.size() >= BUFFER_SIZE;
+            case Flush::FSYNC: return !pending.empty();
+            default: return false;
+        }
+    }
+
+    void writeBatch(const std::string &batch) {
+        auto start = std::chrono::steady_clock::now();
+        const char *p = batch.data();
+        size_t left = batch.size();
+        while (left > 0) {
+            ssize_t n = ::write(fd, p, left);
+            writeCalls.fetch_add(1, std::memory_order_relaxed);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "Failed to write file log " << path << ": " << strerror(errno) << "\n";
+                break;
+            }
+            p += n;
+            left -= n;
+            bytesWritten.fetch_add(n, std::memory_order_relaxed);
+        }
+        if (flush == Flush::FSYNC) {
+            ::fdatasync(fd);
+        }
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        flushes.fetch_add(1, std::memory_order_relaxed);
+        totalFlushNs.fetch_add(ns, std::memory_order_relaxed);
+        if (ns > maxFlushNs.load(std::memory_order_relaxed)) {
+            maxFlushNs.store(ns, std::memory_order_relaxed);
+        }
     }
 };
 
 
 
-class MqttLoggingMethod : public LoggingMethod {
+// mot lan publish dang cho broker xac nhan
+class MqttDelivery {
+public:
+    virtual ~MqttDelivery() = default;
+    virtual bool complete() = 0;
+    // true neu da xong trong timeout
+    virtual bool wait(std::chrono::milliseconds timeout) = 0;
+};
+
+// Ket noi toi broker cua MqttLoggingMethod. PahoMqttLink dung paho; kiem thu co the thay
+// bang mot broker gia (vi du xac nhan cham) qua constructor MqttLoggingMethod(id, link).
+class MqttLink {
+public:
+    virtual ~MqttLink() = default;
+    virtual void connect() = 0;
+    virtual void disconnect() = 0;
+    virtual std::unique_ptr<MqttDelivery> publish(const std::string &topic, const std::string &payload, int qos) = 0;
+};
+
+class PahoMqttLink : public MqttLink {
 private:
+    class Delivery : public MqttDelivery {
+    private:
+        mqtt::delivery_token_ptr token;
+
+    public:
+        explicit Delivery(mqtt::delivery_token_ptr token) : token(token) {}
+
+        bool complete() override {
+            return token->is_complete();
+        }
+
+        bool wait(std::chrono::milliseconds timeout) override {
+            return token->wait_for(timeout);
+        }
+    };
+
     mqtt::async_client mqttClient;
     mqtt::connect_options connOpts;
-    std::string topic = "test_dme";
-    std::queue<std::string> queue;
+
+public:
+    // note: client_id.length >= 1 -> else: error
+    PahoMqttLink(const std::string &address, int id, int window)
+        : mqttClient(address, "mqtt_publisher_" + std::to_string(id)) {
+        connOpts.set_keep_alive_interval(60);
+        connOpts.set_clean_session(true);
+        connOpts.set_max_inflight(window);
+    }
+
+    void connect() override {
+        mqttClient.connect(connOpts)->wait();
+    }
+
+    void disconnect() override {
+        mqttClient.disconnect()->wait();
+    }
+
+    std::unique_ptr<MqttDelivery> publish(const std::string &topic, const std::string &payload, int qos) override {
+        mqtt::message_ptr pubmsg = mqtt::make_message(topic, payload);
+        pubmsg->set_qos(qos);
+        return std::make_unique<Delivery>(mqttClient.publish(pubmsg));
+    }
+};
+
+struct MqttLogStats {
+    uint64_t records;           // ban ghi da duoc broker xac nhan
+    uint64_t messages;          // so ban tin MQTT (moi ban tin toi da MQTT_BATCH ban ghi)
+    uint64_t dropped;           // bo vi hang doi day (MQTT_QUEUE_LIMIT) hoac chua gui khi het han dung
+    uint64_t failures;          // ban tin khong duoc xac nhan trong PUBLISH_TIMEOUT (ca khi dung)
+    size_t backlog;             // ban ghi dang cho gui
+    size_t inFlight;            // ban tin da gui, chua duoc xac nhan
+    uint64_t totalLatencyNs;    // tu luc publish toi luc biet da xac nhan
+    uint64_t maxLatencyNs;
+
+    double averageLatencyUs() const {
+        return messages == 0 ? 0.0 : totalLatencyNs / 1000.0 / messages;
+    }
+};
+
+// Gui log len broker theo kieu pipeline: toi da MQTT_WINDOW ban tin dang cho xac nhan cung
+// luc, moi ban tin gom toi da MQTT_BATCH ban ghi noi bang '\n' (cung dinh dang dong cua
+// log.txt), topic rieng cua node: <MQTT_TOPIC>/<id>. Hang doi co gioi han, day thi bo ban ghi.
+// Ban tin qua PUBLISH_TIMEOUT chua duoc xac nhan bi bo va tinh la loi, du cua so co day hay
+// khong. clean() cho gui not toi da PUBLISH_TIMEOUT, phan con lai tinh la loi / bi bo.
+class MqttLoggingMethod : public LoggingMethod {
+public:
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{2};
+    static constexpr std::chrono::seconds PUBLISH_TIMEOUT{10};
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct InFlight {
+        std::unique_ptr<MqttDelivery> delivery;
+        Clock::time_point sent;
+        size_t records;
+    };
+
+    std::unique_ptr<MqttLink> link;
+    std::string topic;
+    int qos;
+    size_t window;
+    size_t batch;
+    size_t queueLimit;
+    std::chrono::milliseconds publishTimeout;
+    std::deque<std::string> queue;
+    std::deque<InFlight> inFlight;          // chi luong gui dung
     std::mutex mtx;
     std::condition_variable cond;
     std::thread mqttThread;
     bool stop = false;
+    bool connected = false;
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<size_t> backlog{0};
+    std::atomic<size_t> inFlightCount{0};
+    std::atomic<uint64_t> totalLatencyNs{0};
+    std::atomic<uint64_t> maxLatencyNs{0};
 
 public:
-    // note: client_id.length >= 1 -> else: error
-    MqttLoggingMethod(int id) : mqttClient(config.getBrokerAddressMqtt(), "mqtt_publisher_" + std::to_string(id)) {}
+    MqttLoggingMethod(int id)
+        : MqttLoggingMethod(id, std::make_unique<PahoMqttLink>(config.getBrokerAddressMqtt(), id, config.getMqttWindow())) {}
+
+    MqttLoggingMethod(int id, std::unique_ptr<MqttLink> link)
+        : MqttLoggingMethod(id, std::move(link), config.getMqttWindow(), config.getMqttBatch(), config.getMqttQueueLimit()) {}
 
+    // cua so, lo, gioi han hang doi va han xac nhan truyen thang thay vi doc config
+    // (benchmark/mqtt_pipeline_bench.cpp)
+    MqttLoggingMethod(int id, std::unique_ptr<MqttLink> link, size_t window, size_t batch, size_t queueLimit,
+                      std::chrono::milliseconds publishTimeout = PUBLISH_TIMEOUT)
+        : link(std::move(link)), topic(config.getMqttTopic() + "/" + std::to_string(id)), qos(config.getMqttQos()),
+          window(std::max<size_t>(1, window)), batch(std::max<size_t>(1, batch)), queueLimit(queueLimit),
+          publishTimeout(publishTimeout) {}
 
     ~MqttLoggingMethod() {
         clean();
@@ -115,34 +491,79 @@ public:
 
     void init() override {
         LoggingMethod::init();
-        connOpts.set_keep_alive_interval(60);
-        connOpts.set_clean_session(true);
-        mqttClient.connect(connOpts)->wait();
-
+        if (connected) {
+            return;
+        }
+        link->connect();
+        connected = true;
+        stop = false;
         mqttThread = std::thread(&MqttLoggingMethod::processLogs, this);
     }
 
     void log(int id, const std::string &logData) override {
         std::unique_lock<std::mutex> lock(mtx);
-        queue.push(logData);
-        cond.notify_one();
+        if (queue.size() >= queueLimit) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        queue.push_back(logData);
+        backlog.store(queue.size(), std::memory_order_relaxed);
+        if (queue.size() == 1) {
+            cond.notify_one();
+        }
     }
 
     void processLogs() {
+        std::string payload;
+        Clock::time_point drainDeadline = Clock::time_point::max();     // dat khi clean() yeu cau dung
         while (true) {
-            std::string logMessage;
+            size_t count = 0;
             {
                 std::unique_lock<std::mutex> lock(mtx);
-                cond.wait(lock, [this]() { return !queue.empty() || stop; });
-                if (stop && queue.empty()) {
+                // con ban tin cho xac nhan thi chi ngu ngan de con thu hoi
+                if (inFlight.empty()) {
+                    cond.wait(lock, [this]() { return !queue.empty() || stop; });
+                } else {
+                    cond.wait_for(lock, POLL_INTERVAL, [this]() { return !queue.empty() || stop; });
+                }
+                if (stop && drainDeadline == Clock::time_point::max()) {
+                    drainDeadline = Clock::now() + publishTimeout;
+                }
+                if (stop && ((queue.empty() && inFlight.empty()) || Clock::now() >= drainDeadline)) {
+                    // het han gui not: ban tin chua xac nhan la loi, ban ghi chua gui bi bo
+                    failures.fetch_add(inFlight.size(), std::memory_order_relaxed);
+                    dropped.fetch_add(queue.size(), std::memory_order_relaxed);
+                    inFlight.clear();
+                    queue.clear();
+                    inFlightCount.store(0, std::memory_order_relaxed);
+                    backlog.store(0, std::memory_order_relaxed);
                     break;
                 }
-                logMessage = queue.front();
-                queue.pop();
+                if (inFlight.size() < window) {
+                    payload.clear();
+                    while (!queue.empty() && count < batch) {
+                        if (count > 0) {
+                            payload += '\n';
+                        }
+                        payload += queue.front();
+                        queue.pop_front();
+                        count++;
+                    }
+                    backlog.store(queue.size(), std::memory_order_relaxed);
+                }
+            }
+            if (count > 0) {
+                inFlight.push_back(InFlight{link->publish(topic, payload, qos), Clock::now(), count});
+                inFlightCount.store(inFlight.size(), std::memory_order_relaxed);
             }
-            mqtt::message_ptr pubmsg = mqtt::make_message(topic, logMessage);
-            pubmsg->set_qos(1);
-            mqttClient.publish(pubmsg)->wait();
+            // cua so day: cho ban tin cu nhat toi han cua no (hoac han dung); retire() thu hoi
+            // ban tin da xong va bo ban tin qua han
+            if (inFlight.size() >= window) {
+                auto deadline = std::min(inFlight.front().sent + publishTimeout, drainDeadline);
+                auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+                inFlight.front().delivery->wait(std::max(remaining, std::chrono::milliseconds(0)));
+            }
+            retire();
         }
     }
 
@@ -155,7 +576,40 @@ public:
         if (mqttThread.joinable()) {
             mqttThread.join();
         }
-        mqttClient.disconnect()->wait();
+        if (connected) {
+            link->disconnect();
+            connected = false;
+        }
+    }
+
+    MqttLogStats getStats() const {
+        return MqttLogStats{records.load(), messages.load(), dropped.load(), failures.load(), backlog.load(),
+                            inFlightCount.load(), totalLatencyNs.load(), maxLatencyNs.load()};
+    }
+
+private:
+    void retire() {
+        auto now = Clock::now();
+        for (auto it = inFlight.begin(); it != inFlight.end();) {
+            if (!it->delivery->complete()) {
+                if (now - it->sent >= publishTimeout) {
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                    it = inFlight.erase(it);
+                } else {
+                    ++it;
+                }
+                continue;
+            }
+            uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - it->sent).count();
+            records.fetch_add(it->records, std::memory_order_relaxed);
+            messages.fetch_add(1, std::memory_order_relaxed);
+            totalLatencyNs.fetch_add(ns, std::memory_order_relaxed);
+            if (ns > maxLatencyNs.load(std::memory_order_relaxed)) {
+                maxLatencyNs.store(ns, std::memory_order_relaxed);
+            }
+            it = inFlight.erase(it);
+        }
+        inFlightCount.store(inFlight.size(), std::memory_order_relaxed);
     }
 };
 
@@ -166,15 +620,40 @@ protected:
     bool toFile;
     bool toMqtt;
     std::list<std::shared_ptr<LoggingMethod>> methods;
+    std::shared_ptr<FileLoggingMethod> fileMethod;
+    std::shared_ptr<MqttLoggingMethod> mqttMethod;
     std::chrono::steady_clock::time_point startTime;
     std::string pointTime;
+    LogLevel level;
+    uint32_t categories;
+    // bit cua cac loai dang duoc ghi: da tinh ca muc, bo loc loai va sink con ghi duoc,
+    // nen kiem tra truoc moi ban ghi chi la mot lan doc atomic
+    std::atomic<uint32_t> active{0};
+    // LOG_BACKEND=ring: luong goi log chi ma hoa note (BinaryLog::encodeNote) va chep ban ghi
+    // vao ring cua minh; dung dong JSON va ghi ra sink o luong doc cua backend. Null thi ghi
+    // thang tren luong goi
+    std::unique_ptr<LogRingBackend> ring;
+    bool binary;                // LOG_FORMAT=binary: note duoc ma hoa nhi phan ngay tren luong goi
 
 public:
-    Logger(int id, bool console, bool file, bool mqtt) : id(id), toConsole(console), toFile(file), toMqtt(mqtt) {
+    Logger(int id, bool console, bool file, bool mqtt)
+        : id(id), toConsole(console), toFile(file), toMqtt(mqtt),
+          level(parseLogLevel(config.getLogLevel())), categories(parseLogCategories(config.getLogCategories())),
+          binary(config.getLogFormat() == "binary") {
         init();
+        if (config.getLogBackend() == "ring") {
+            LogRingBackend::Policy policy = config.getLogRingPolicy() == "drop" ? LogRingBackend::Policy::DROP
+                                                                                : LogRingBackend::Policy::BLOCK;
+            ring = std::make_unique<LogRingBackend>(config.getLogRingCapacity(), policy,
+                [this](const LogRing::Entry &entry) {
+                    emit(entry.timeNs, entry.type, entry.id, entry.content, entry.truncated ? truncatedNote() : entry.note,
+                         true);
+                });
+        }
     }
 
     ~Logger() {
+        ring.reset();
         for (auto& m : methods) {
             m->clean();
         }
@@ -185,8 +664,14 @@ public:
         pointTime = getPointTime();
 
         if (toConsole) methods.push_back(std::make_shared<ConsoleLoggingMethod>());
-        if (toFile) methods.push_back(std::make_shared<FileLoggingMethod>());
-        if (toMqtt) methods.push_back(std::make_shared<MqttLoggingMethod>(id));
+        if (toFile) {
+            fileMethod = std::make_shared<FileLoggingMethod>(id, pointTime);
+            methods.push_back(fileMethod);
+        }
+        if (toMqtt) {
+            mqttMethod = std::make_shared<MqttLoggingMethod>(id);
+            methods.push_back(mqttMethod);
+        }
         reset();
     }
 
@@ -194,6 +679,34 @@ public:
         for (auto& m : methods) {
             m->init();
         }
+        refresh();
+    }
+
+    // doi muc / bo loc khi dang chay
+    void setLevel(LogLevel newLevel) {
+        level = newLevel;
+        refresh();
+    }
+
+    void setCategories(uint32_t mask) {
+        categories = mask;
+        refresh();
+    }
+
+    bool enabled(LogCategory category) const {
+        return (active.load(std::memory_order_relaxed) >> static_cast<size_t>(category)) & 1;
+    }
+
+    FileLogStats getFileStats() const {
+        return fileMethod ? fileMethod->getStats() : FileLogStats{0, 0, 0, 0, 0, 0};
+    }
+
+    MqttLogStats getMqttStats() const {
+        return mqttMethod ? mqttMethod->getStats() : MqttLogStats{0, 0, 0, 0, 0, 0, 0, 0};
+    }
+
+    LogRingStats getRingStats() const {
+        return ring ? ring->getStats() : LogRingStats{0, 0, 0, 0, 0};
     }
 
     std::string getPointTime() {
@@ -212,6 +725,11 @@ public:
         return static_cast<int>(duration);
     }
 
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     /*
         type: notice, send, receive, error
         algorithm: permission, token
@@ -248,19 +766,27 @@ public:
     //     }
     // }
 
+    // ban ghi dung san; van bi loc theo loai truoc khi dump
     void log(const std::string &type, int id, const std::string &content, json note) {
-        json data;
-        data["timeInit"] = pointTime;
-        data["duration_ms"] = getDuration();
-        data["type"] = type;
-        data["id"] = id;
-        data["content"] = content;
-        data["note"] = note;
-        std::string logData = data.dump();
+        if (!enabled(parseLogCategory(type))) {
+            return;
+        }
+        write(type, id, content, note);
+    }
 
-        for (auto &m : methods) {
-            m->log(id, logData);
+    // ban ghi luoi: build(note) dien note va tra ve content, chi duoc goi khi loai dang bat
+    //     logger->log(LogCategory::SEND, id, [&](json &note) {
+    //         note["dest"] = dest;
+    //         return std::to_string(id) + " sent token to " + std::to_string(dest);
+    //     });
+    template <typename Build>
+    void log(LogCategory category, int id, Build &&build) {
+        if (!enabled(category)) {
+            return;
         }
+        json note;
+        std::string content = build(note);
+        write(logCategoryName(category), id, content, note);
     }
 
     // void log(const std::string &type, const std::string &algorithm, int source, int dest, const std::string &direction, bool permissionOrToken, const std::string &state, const std::string &content) {
@@ -311,6 +837,78 @@ public:
     //         m->log(id, receiver, logMessage);
     //     }
     // }
+
+private:
+    // qua ring thi note luon o dang nhi phan, ke ca khi LOG_FORMAT=json: ma hoa varint re hon
+    // dump JSON nhieu, phan dump de cho luong doc
+    void write(const std::string &type, int id, const std::string &content, const json &note) {
+        if (ring) {
+            ring->push(nowNs(), id, type, content, BinaryLog::encodeNote(note));
+        } else if (binary) {
+            emit(nowNs(), type, id, content, BinaryLog::encodeNote(note), true);
+        } else {
+            emit(nowNs(), type, id, content, note.dump(), false);
+        }
+    }
+
+    std::string truncatedNote() const {
+        json note;
+        note["truncated"] = true;
+        return BinaryLog::encodeNote(note);
+    }
+
+    // dinh dang ban ghi (note da ma hoa san, nhi phan neu binaryNote) va dua cho cac sink;
+    // duration_ms tinh theo thoi diem goi log chu khong phai luc ghi ra. Sink nhi phan nhan
+    // thang note nhi phan, sink con lai nhan dong JSON (giai ma note neu can)
+    void emit(uint64_t timeNs, const std::string &type, int id, const std::string &content, const std::string &note,
+              bool binaryNote) {
+        uint64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(startTime.time_since_epoch()).count();
+        uint64_t timeUs = timeNs > startNs ? (timeNs - startNs) / 1000 : 0;
+        bool needText = !binary;
+        for (auto &m : methods) {
+            if (binary && m->ready() && m->binary()) {
+                m->logBinary(timeUs, type, id, content, note);
+            } else {
+                needText = needText || m->ready();
+            }
+        }
+        if (!needText) {
+            return;
+        }
+        json data;
+        data["timeInit"] = pointTime;
+        data["duration_ms"] = static_cast<int>(timeUs / 1000);
+        data["type"] = type;
+        data["id"] = id;
+        data["content"] = content;
+        // content bi cat co the vo mot ky tu UTF-8
+        std::string logData = data.dump(-1, ' ', false, json::error_handler_t::replace);
+        logData.pop_back();
+        logData += ",\"note\":";
+        logData += binaryNote ? BinaryLog::decodeNote(note).dump(-1, ' ', false, json::error_handler_t::replace) : note;
+        logData += '}';
+
+        for (auto &m : methods) {
+            if (m->ready() && !(binary && m->binary())) {
+                m->log(id, logData);
+            }
+        }
+    }
+
+    void refresh() {
+        bool anySink = false;
+        for (auto &m : methods) {
+            anySink = anySink || m->ready();
+        }
+        uint32_t mask = 0;
+        for (size_t i = 0; anySink && i < static_cast<size_t>(LogCategory::COUNT); i++) {
+            LogCategory category = static_cast<LogCategory>(i);
+            if (((categories >> i) & 1) && logCategoryLevel(category) >= level) {
+                mask |= 1u << i;
+            }
+        }
+        active.store(mask, std::memory_order_relaxed);
+    }
 };
 
 
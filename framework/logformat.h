@@ -0,0 +1,344 @@
+// logformat.h
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+// Dinh dang log nhi phan (LOG_FORMAT=binary). File la chuoi muc, moi muc mo dau bang varint
+// do dai L:
+//   L = 0   dau phien: "DMEL" | version(1) | id logger (varint) | timeInit (chuoi)
+//   L > 0   ban ghi L byte: delta thoi gian us so voi ban ghi truoc (zigzag) | type | id (zigzag)
+//           | content (chuoi) | note
+// Chuoi = varint do dai + byte. type la chi so trong TYPES, 0xFF + chuoi neu khac.
+// note = so truong (varint) roi tung truong: khoa (chi so trong KEYS + 1, 0 + chuoi neu khac)
+// va gia tri co the (xem Value). note khong phai object duoc ghi nguyen bang msgpack.
+// logconvert.cpp dich nguoc ra dung dong JSON cua Logger.
+namespace BinaryLog {
+
+typedef nlohmann::ordered_json json;
+
+static const char MAGIC[4] = {'D', 'M', 'E', 'L'};
+static const uint8_t VERSION = 1;
+
+// bang chuoi dung chung cua schema; chi duoc them vao cuoi
+static const char *const TYPES[] = {"send", "receive", "notice", "error", "stats"};
+static const char *const KEYS[] = {"status", "init", "error", "source", "dest", "last", "next", "lost", "truncated"};
+static const char *const VALUES[] = {"null", "ok", "broadcast", "unreachable", "suspect"};
+
+enum Value : uint8_t {
+    SIGNED = 0,     // zigzag varint
+    UNSIGNED,       // varint, so lon hon int64
+    KNOWN,          // chi so trong VALUES
+    STRING,
+    BOOL_TRUE,
+    BOOL_FALSE,
+    NULL_VALUE,
+    PACKED,         // msgpack: so thuc, mang, object long nhau
+};
+
+enum Note : uint8_t {
+    OBJECT = 0,
+    NOTE_NULL,
+    NOTE_PACKED,
+};
+
+inline void putVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline void putSigned(std::string &out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+inline void putString(std::string &out, const std::string &value) {
+    putVarint(out, value.size());
+    out += value;
+}
+
+template <size_t N>
+inline int indexOf(const char *const (&table)[N], const std::string &value) {
+    for (size_t i = 0; i < N; i++) {
+        if (value == table[i]) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// doc tu [p, end); nem loi khi du lieu bi cat
+class Reader {
+private:
+    const char *p;
+    const char *end;
+
+public:
+    Reader(const char *p, const char *end) : p(p), end(end) {}
+
+    bool done() const {
+        return p == end;
+    }
+
+    uint8_t byte() {
+        if (p == end) {
+            throw std::runtime_error("truncated binary log\n");
+        }
+        return static_cast<uint8_t>(*p++);
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("bad varint in binary log\n");
+    }
+
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    size_t remaining() const {
+        return static_cast<size_t>(end - p);
+    }
+
+    std::string bytes(uint64_t size) {
+        if (size > remaining()) {
+            throw std::runtime_error("truncated binary log\n");
+        }
+        std::string value(p, size);
+        p += size;
+        return value;
+    }
+
+    std::string string() {
+        return bytes(varint());
+    }
+};
+
+inline void encodeValue(std::string &out, const json &value) {
+    if (value.is_number_unsigned() && value.get<uint64_t>() > static_cast<uint64_t>(INT64_MAX)) {
+        out += static_cast<char>(UNSIGNED);
+        putVarint(out, value.get<uint64_t>());
+    } else if (value.is_number_integer()) {
+        out += static_cast<char>(SIGNED);
+        putSigned(out, value.get<int64_t>());
+    } else if (value.is_string()) {
+        const std::string &s = value.get_ref<const std::string &>();
+        int known = indexOf(VALUES, s);
+        if (known >= 0) {
+            out += static_cast<char>(KNOWN);
+            putVarint(out, known);
+        } else {
+            out += static_cast<char>(STRING);
+            putString(out, s);
+        }
+    } else if (value.is_boolean()) {
+        out += static_cast<char>(value.get<bool>() ? BOOL_TRUE : BOOL_FALSE);
+    } else if (value.is_null()) {
+        out += static_cast<char>(NULL_VALUE);
+    } else {
+        std::vector<uint8_t> packed = json::to_msgpack(value);
+        out += static_cast<char>(PACKED);
+        putString(out, std::string(packed.begin(), packed.end()));
+    }
+}
+
+inline json decodeValue(Reader &in) {
+    switch (in.byte()) {
+        case SIGNED: return json(in.signedVarint());
+        case UNSIGNED: return json(in.varint());
+        case KNOWN: {
+            uint64_t index = in.varint();
+            if (index >= sizeof(VALUES) / sizeof(VALUES[0])) {
+                throw std::runtime_error("unknown value in binary log\n");
+            }
+            return json(VALUES[index]);
+        }
+        case STRING: return json(in.string());
+        case BOOL_TRUE: return json(true);
+        case BOOL_FALSE: return json(false);
+        case NULL_VALUE: return json(nullptr);
+        case PACKED: {
+            std::string packed = in.string();
+            return json::from_msgpack(packed.begin(), packed.end());
+        }
+    }
+    throw std::runtime_error("bad value tag in binary log\n");
+}
+
+// note cua mot ban ghi; luong goi log ma hoa, file sink chep nguyen khong dung lai JSON
+inline std::string encodeNote(const json &note) {
+    std::string out;
+    if (note.is_object()) {
+        out += static_cast<char>(OBJECT);
+        putVarint(out, note.size());
+        for (auto &field : note.items()) {
+            int key = indexOf(KEYS, field.key());
+            putVarint(out, key + 1);
+            if (key < 0) {
+                putString(out, field.key());
+            }
+            encodeValue(out, field.value());
+        }
+    } else if (note.is_null()) {
+        out += static_cast<char>(NOTE_NULL);
+    } else {
+        std::vector<uint8_t> packed = json::to_msgpack(note);
+        out += static_cast<char>(NOTE_PACKED);
+        putString(out, std::string(packed.begin(), packed.end()));
+    }
+    return out;
+}
+
+inline json decodeNote(Reader &in) {
+    switch (in.byte()) {
+        case OBJECT: {
+            json note = json::object();
+            uint64_t count = in.varint();
+            for (uint64_t i = 0; i < count; i++) {
+                uint64_t key = in.varint();
+                std::string name;
+                if (key == 0) {
+                    name = in.string();
+                } else if (key <= sizeof(KEYS) / sizeof(KEYS[0])) {
+                    name = KEYS[key - 1];
+                } else {
+                    throw std::runtime_error("unknown key in binary log\n");
+                }
+                note[name] = decodeValue(in);
+            }
+            return note;
+        }
+        case NOTE_NULL: return json();
+        case NOTE_PACKED: {
+            std::string packed = in.string();
+            return json::from_msgpack(packed.begin(), packed.end());
+        }
+    }
+    throw std::runtime_error("bad note tag in binary log\n");
+}
+
+inline json decodeNote(const std::string &encoded) {
+    Reader in(encoded.data(), encoded.data() + encoded.size());
+    return decodeNote(in);
+}
+
+// ghi mot file: giu thoi diem ban ghi truoc de ma hoa delta; khong an toan luong,
+// FileLoggingMethod goi khi dang giu khoa
+class Writer {
+private:
+    uint64_t previousUs = 0;
+    std::string record;
+
+public:
+    void session(std::string &out, int id, const std::string &timeInit) {
+        previousUs = 0;
+        putVarint(out, 0);
+        out.append(MAGIC, sizeof(MAGIC));
+        out += static_cast<char>(VERSION);
+        putSigned(out, id);
+        putString(out, timeInit);
+    }
+
+    // timeUs tinh tu luc Logger khoi tao; note da duoc encodeNote
+    void append(std::string &out, uint64_t timeUs, const std::string &type, int id,
+                const std::string &content, const std::string &note) {
+        record.clear();
+        putSigned(record, static_cast<int64_t>(timeUs - previousUs));
+        previousUs = timeUs;
+        int known = indexOf(TYPES, type);
+        if (known >= 0) {
+            record += static_cast<char>(known);
+        } else {
+            record += static_cast<char>(0xFF);
+            putString(record, type);
+        }
+        putSigned(record, id);
+        putString(record, content);
+        record += note;
+        putVarint(out, record.size());
+        out += record;
+    }
+};
+
+// doc lan luot cac ban ghi, tra ve dung dong JSON ma Logger ghi o LOG_FORMAT=json
+class Decoder {
+private:
+    Reader in;
+    std::string timeInit;
+    uint64_t timeUs = 0;
+    bool inSession = false;
+
+public:
+    Decoder(const char *data, size_t size) : in(data, data + size) {}
+
+    // false khi het du lieu; ban ghi cuoi bi cat do dang ghi thi bo qua
+    bool next(std::string &line) {
+        while (!in.done()) {
+            uint64_t size = in.varint();
+            if (size == 0) {
+                char magic[sizeof(MAGIC)];
+                for (char &c : magic) {
+                    c = static_cast<char>(in.byte());
+                }
+                if (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+                    throw std::runtime_error("not a binary log\n");
+                }
+                if (in.byte() != VERSION) {
+                    throw std::runtime_error("unsupported binary log version\n");
+                }
+                in.signedVarint();
+                timeInit = in.string();
+                timeUs = 0;
+                inSession = true;
+                continue;
+            }
+            if (!inSession) {
+                throw std::runtime_error("binary log without session header\n");
+            }
+            if (size > in.remaining()) {
+                return false;
+            }
+            std::string body = in.bytes(size);
+            Reader record(body.data(), body.data() + body.size());
+            timeUs += static_cast<uint64_t>(record.signedVarint());
+            uint8_t typeCode = record.byte();
+            std::string type;
+            if (typeCode == 0xFF) {
+                type = record.string();
+            } else if (typeCode < sizeof(TYPES) / sizeof(TYPES[0])) {
+                type = TYPES[typeCode];
+            } else {
+                throw std::runtime_error("unknown type in binary log\n");
+            }
+            json data;
+            data["timeInit"] = timeInit;
+            data["duration_ms"] = static_cast<int>(timeUs / 1000);
+            data["type"] = type;
+            data["id"] = static_cast<int>(record.signedVarint());
+            data["content"] = record.string();
+            data["note"] = decodeNote(record);
+            line = data.dump(-1, ' ', false, json::error_handler_t::replace);
+            return true;
+        }
+        return false;
+    }
+};
+
+}
+
+#endif // LOGFORMAT_H
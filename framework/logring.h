@@ -0,0 +1,379 @@
+// logring.h
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+struct LogRingStats {
+    uint64_t records;           // so ban ghi da chuyen cho sink
+    uint64_t dropped;           // bo vi ring day (LOG_RING_POLICY=drop) hoac logger dang dong
+    uint64_t blocked;           // so ban ghi ma luong ghi phai cho vi ring day (LOG_RING_POLICY=block)
+    uint64_t truncated;         // ban ghi dai hon ca ring, note duoc thay bang {"truncated":true}
+    size_t rings;               // so luong ghi dang co ring
+};
+
+// Ring mot luong ghi - mot luong doc gom cac o kich thuoc co dinh. Mot ban ghi chiem mot
+// hoac vai o lien tiep: header o dau o dau tien, sau do la type | content | note.
+class LogRing {
+public:
+    static const size_t SLOT_SIZE = 128;
+
+    struct Header {
+        uint64_t timeNs;        // steady_clock luc goi log
+        int32_t id;
+        uint32_t slots;
+        uint8_t typeLen;
+        uint8_t truncated;      // 1: ban ghi lon hon ca ring, note bi bo, content bi cat
+        uint32_t contentLen;
+        uint32_t noteLen;
+    };
+
+    struct Entry {
+        uint64_t timeNs;
+        int id;
+        std::string type;
+        std::string content;
+        std::string note;
+        bool truncated;
+    };
+
+private:
+    struct Slot {
+        char bytes[SLOT_SIZE];
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};    // chi luong doc thay doi
+    alignas(64) std::atomic<size_t> tail{0};    // chi luong ghi thay doi
+    size_t cachedHead = 0;                      // ban sao head cua luong ghi, tranh doc cache line cua luong doc
+
+public:
+    std::atomic<bool> orphaned{false};          // luong ghi da ket thuc, bo ring khi doc het
+
+    // capacity (so o) duoc lam tron len luy thua cua 2
+    explicit LogRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    static size_t slotsFor(size_t bytes) {
+        return (sizeof(Header) + bytes + SLOT_SIZE - 1) / SLOT_SIZE;
+    }
+
+    // luong ghi; false neu chua du cho. Ban ghi lon hon ca ring bi bo note va cat content
+    bool tryWrite(uint64_t timeNs, int id, std::string_view type, std::string_view content,
+                  std::string_view note, bool &truncated) {
+        type = type.substr(0, 255);
+        size_t maxBytes = capacity() * SLOT_SIZE - sizeof(Header);
+        truncated = type.size() + content.size() + note.size() > maxBytes;
+        if (truncated) {
+            note = std::string_view();
+            content = content.substr(0, maxBytes - type.size());
+        }
+        size_t count = slotsFor(type.size() + content.size() + note.size());
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t + count - cachedHead > capacity()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t + count - cachedHead > capacity()) {
+                return false;
+            }
+        }
+        Header header{timeNs, id, static_cast<uint32_t>(count), static_cast<uint8_t>(type.size()), truncated,
+                      static_cast<uint32_t>(content.size()), static_cast<uint32_t>(note.size())};
+        size_t offset = 0;
+        copyIn(t, offset, &header, sizeof(header));
+        copyIn(t, offset, type.data(), type.size());
+        copyIn(t, offset, content.data(), content.size());
+        copyIn(t, offset, note.data(), note.size());
+        tail.store(t + count, std::memory_order_release);
+        return true;
+    }
+
+    // luong doc: thoi diem cua ban tin dau ring, false neu ring rong
+    bool peek(uint64_t &timeNs) const {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        memcpy(&timeNs, slots[h & mask].bytes, sizeof(timeNs));
+        return true;
+    }
+
+    // luong doc, chi goi sau khi peek thanh cong
+    void read(Entry &entry) {
+        size_t h = head.load(std::memory_order_relaxed);
+        Header header;
+        size_t offset = 0;
+        copyOut(h, offset, &header, sizeof(header));
+        entry.timeNs = header.timeNs;
+        entry.id = header.id;
+        entry.truncated = header.truncated != 0;
+        copyOut(h, offset, entry.type, header.typeLen);
+        copyOut(h, offset, entry.content, header.contentLen);
+        copyOut(h, offset, entry.note, header.noteLen);
+        head.store(h + header.slots, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    // offset tinh tu dau ban ghi; moi o lien tuc trong bo nho nhung hai o ke nhau co the o hai dau vector
+    void copyIn(size_t start, size_t &offset, const void *data, size_t size) {
+        const char *p = static_cast<const char *>(data);
+        while (size > 0) {
+            size_t inSlot = offset % SLOT_SIZE;
+            size_t n = std::min(size, SLOT_SIZE - inSlot);
+            memcpy(slots[(start + offset / SLOT_SIZE) & mask].bytes + inSlot, p, n);
+            p += n;
+            offset += n;
+            size -= n;
+        }
+    }
+
+    void copyOut(size_t start, size_t &offset, void *data, size_t size) const {
+        char *p = static_cast<char *>(data);
+        while (size > 0) {
+            size_t inSlot = offset % SLOT_SIZE;
+            size_t n = std::min(size, SLOT_SIZE - inSlot);
+            memcpy(p, slots[(start + offset / SLOT_SIZE) & mask].bytes + inSlot, n);
+            p += n;
+            offset += n;
+            size -= n;
+        }
+    }
+
+    void copyOut(size_t start, size_t &offset, std::string &out, size_t size) const {
+        out.resize(size);
+        copyOut(start, offset, &out[0], size);
+    }
+};
+
+// Backend cua Logger: moi luong goi log ghi vao ring rieng cua no (khong khoa, khong
+// system call tru khi luong doc dang ngu), mot luong doc gom tat ca ring theo thu tu
+// thoi diem roi goi sink. Ring day thi bo ban ghi hoac cho, tuy policy.
+class LogRingBackend {
+public:
+    typedef std::function<void(const LogRing::Entry &)> Sink;
+
+    enum class Policy {
+        DROP,
+        BLOCK,
+    };
+
+private:
+    // ring cua luong hien tai, theo tung backend (co the co nhieu Logger trong mot tien trinh)
+    struct LocalRings {
+        std::vector<std::pair<uint64_t, std::shared_ptr<LogRing>>> rings;
+
+        ~LocalRings() {
+            for (auto &ring : rings) {
+                ring.second->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    static LocalRings &localRings() {
+        static thread_local LocalRings rings;
+        return rings;
+    }
+
+    static uint64_t nextBackendId() {
+        static std::atomic<uint64_t> next{1};
+        return next++;
+    }
+
+    uint64_t backendId;
+    size_t capacity;
+    Policy policy;
+    Sink sink;
+    std::mutex ringsMutex;                          // chi khi them ring moi va luong doc lay danh sach
+    std::vector<std::shared_ptr<LogRing>> rings;
+    std::atomic<uint64_t> ringsVersion{0};
+    std::atomic<bool> stopping{false};
+    alignas(64) std::atomic<uint32_t> sleeping{0};
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> blocked{0};
+    std::atomic<uint64_t> truncated{0};
+    std::atomic<size_t> ringCount{0};
+    std::thread m_consumerThread;
+
+public:
+    LogRingBackend(size_t capacity, Policy policy, Sink sink)
+        : backendId(nextBackendId()), capacity(capacity), policy(policy), sink(sink) {
+        m_consumerThread = std::thread(&LogRingBackend::consumerThread, this);
+    }
+
+    // ghi not cac ban ghi con trong ring roi dung
+    ~LogRingBackend() {
+        stopping.store(true);
+        wake();
+        if (m_consumerThread.joinable()) {
+            m_consumerThread.join();
+        }
+    }
+
+    void push(uint64_t timeNs, int id, std::string_view type, std::string_view content, std::string_view note) {
+        LogRing &ring = local();
+        bool cut = false;
+        bool waited = false;
+        while (!ring.tryWrite(timeNs, id, type, content, note, cut)) {
+            if (policy == Policy::DROP || stopping.load(std::memory_order_relaxed)) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                wake();
+                return;
+            }
+            if (!waited) {
+                blocked.fetch_add(1, std::memory_order_relaxed);
+                waited = true;
+            }
+            wake();
+            std::this_thread::yield();
+        }
+        if (cut) {
+            truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+        wake();
+    }
+
+    LogRingStats getStats() const {
+        return LogRingStats{records.load(), dropped.load(), blocked.load(), truncated.load(), ringCount.load()};
+    }
+
+private:
+    LogRing &local() {
+        LocalRings &locals = localRings();
+        for (auto &ring : locals.rings) {
+            if (ring.first == backendId) {
+                return *ring.second;
+            }
+        }
+        auto ring = std::make_shared<LogRing>(capacity);
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(ring);
+            ringCount.store(rings.size());
+        }
+        ringsVersion++;
+        locals.rings.emplace_back(backendId, ring);
+        return *ring;
+    }
+
+    void consumerThread() {
+        std::vector<std::shared_ptr<LogRing>> snapshot;
+        uint64_t version = 0;
+        LogRing::Entry entry;
+        while (true) {
+            uint64_t current = ringsVersion.load();
+            if (current != version) {
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                snapshot = rings;
+                version = current;
+            }
+            bool stop = stopping.load();
+            size_t drained = drain(snapshot, entry);
+            if (drained == 0) {
+                removeOrphaned(snapshot);
+                if (stop) {
+                    break;
+                }
+                park();
+            }
+        }
+    }
+
+    // lay ban ghi som nhat trong cac dau ring cho toi khi tat ca rong
+    size_t drain(const std::vector<std::shared_ptr<LogRing>> &snapshot, LogRing::Entry &entry) {
+        size_t drained = 0;
+        while (true) {
+            LogRing *earliest = nullptr;
+            uint64_t earliestNs = 0;
+            for (auto &ring : snapshot) {
+                uint64_t timeNs;
+                if (ring->peek(timeNs) && (earliest == nullptr || timeNs < earliestNs)) {
+                    earliest = ring.get();
+                    earliestNs = timeNs;
+                }
+            }
+            if (earliest == nullptr) {
+                return drained;
+            }
+            earliest->read(entry);
+            sink(entry);
+            records.fetch_add(1, std::memory_order_relaxed);
+            drained++;
+        }
+    }
+
+    void removeOrphaned(std::vector<std::shared_ptr<LogRing>> &snapshot) {
+        bool any = false;
+        for (auto &ring : snapshot) {
+            any = any || (ring->orphaned.load(std::memory_order_acquire) && ring->empty());
+        }
+        if (!any) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<LogRing> &ring) {
+            return ring->orphaned.load(std::memory_order_acquire) && ring->empty();
+        }), rings.end());
+        ringCount.store(rings.size());
+        snapshot = rings;
+    }
+
+    // giong Inbox::park nhung co timeout de nhan ra ring moi va luong ghi da ket thuc
+    void park() {
+        sleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!stopping.load() && !pending()) {
+            timespec timeout{0, 50 * 1000 * 1000};
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&sleeping), FUTEX_WAIT_PRIVATE, 1, &timeout, nullptr, 0);
+        }
+        sleeping.store(0, std::memory_order_relaxed);
+    }
+
+    bool pending() {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (auto &ring : rings) {
+            if (!ring->empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) == 1 && sleeping.exchange(0) == 1) {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&sleeping), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+    }
+};
+
+#endif // LOGRING_H
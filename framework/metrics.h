@@ -0,0 +1,221 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "buffer.h"
+#include <atomic>
+#include <array>
+#include <vector>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+// Duoi dat truoc checksum cua moi frame Comm: nguon(4) | thoi diem gui(8, ns, dong ho he thong).
+// Ben nhan lay ra de dem theo peer va do tre mot chieu; chi chinh xac khi dong ho cac may
+// dong bo (cung may thi luon dung).
+struct FrameStamp {
+    static const size_t SIZE = 12;
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static void append(std::string &frame, uint32_t source, uint64_t sentNs) {
+        char stamp[SIZE];
+        for (int i = 0; i < 4; i++) {
+            stamp[i] = static_cast<char>(source >> (24 - 8 * i));
+        }
+        for (int i = 0; i < 8; i++) {
+            stamp[4 + i] = static_cast<char>(sentNs >> (56 - 8 * i));
+        }
+        frame.append(stamp, SIZE);
+    }
+
+    // bo duoi khoi frame; tra ve false neu frame qua ngan
+    static bool strip(Buffer &frame, uint32_t &source, uint64_t &sentNs) {
+        if (frame.size() < SIZE) {
+            return false;
+        }
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(frame.data() + frame.size() - SIZE);
+        source = 0;
+        for (int i = 0; i < 4; i++) {
+            source = (source << 8) | p[i];
+        }
+        sentNs = 0;
+        for (int i = 0; i < 8; i++) {
+            sentNs = (sentNs << 8) | p[4 + i];
+        }
+        frame.removeSuffix(SIZE);
+        return true;
+    }
+};
+
+struct LatencyStats {
+    uint64_t count;
+    uint64_t totalUs;
+    uint64_t maxUs;
+    uint64_t p50Us;             // can tren cua bucket chua phan vi
+    uint64_t p99Us;
+    std::vector<uint64_t> buckets;  // bucket 0: < 1us, bucket i: [2^(i-1), 2^i) us
+
+    double averageUs() const {
+        return count == 0 ? 0.0 : static_cast<double>(totalUs) / count;
+    }
+};
+
+// Histogram do tre theo luy thua 2 (micro giay), chi dung bien dem atomic nen
+// nhieu luong nhan ghi dong thoi khong can khoa.
+class LatencyHistogram {
+public:
+    static const size_t BUCKETS = 32;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalUs{0};
+    std::atomic<uint64_t> maxUs{0};
+
+public:
+    void record(uint64_t us) {
+        size_t bucket = 0;
+        while (bucket + 1 < BUCKETS && (us >> bucket) != 0) {
+            bucket++;
+        }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalUs.fetch_add(us, std::memory_order_relaxed);
+        uint64_t seen = maxUs.load(std::memory_order_relaxed);
+        while (us > seen && !maxUs.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {}
+    }
+
+    LatencyStats snapshot() const {
+        LatencyStats stats{count.load(), totalUs.load(), maxUs.load(), 0, 0, std::vector<uint64_t>(BUCKETS)};
+        uint64_t total = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            stats.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            total += stats.buckets[i];
+        }
+        stats.p50Us = percentile(stats.buckets, total, 50);
+        stats.p99Us = percentile(stats.buckets, total, 99);
+        return stats;
+    }
+
+private:
+    static uint64_t percentile(const std::vector<uint64_t> &buckets, uint64_t total, uint64_t pct) {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t target = (total * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen >= target) {
+                return i == 0 ? 1 : (1ULL << i);
+            }
+        }
+        return 1ULL << (buckets.size() - 1);
+    }
+};
+
+struct PeerStats {
+    int peerId;
+    uint64_t messagesSent;
+    uint64_t bytesSent;
+    uint64_t sendErrors;        // transport bao gui that bai
+    uint64_t queueDrops;        // bo vi hang doi gui cua peer da day
+    size_t queueDepth;          // so ban tin dang cho gui toi peer
+    uint64_t connectFailures;   // so lan mo ket noi toi peer that bai
+    uint64_t messagesReceived;
+    uint64_t bytesReceived;
+    LatencyStats latency;       // do tre mot chieu cua ban tin tu peer (tu luc Comm::send ben gui)
+
+    nlohmann::ordered_json toJson() const {
+        nlohmann::ordered_json out;
+        out["peer"] = peerId;
+        out["sent"] = messagesSent;
+        out["bytesSent"] = bytesSent;
+        out["sendErrors"] = sendErrors;
+        out["queueDrops"] = queueDrops;
+        out["queueDepth"] = queueDepth;
+        out["connectFailures"] = connectFailures;
+        out["received"] = messagesReceived;
+        out["bytesReceived"] = bytesReceived;
+        out["latencyAvgUs"] = latency.averageUs();
+        out["latencyP50Us"] = latency.p50Us;
+        out["latencyP99Us"] = latency.p99Us;
+        out["latencyMaxUs"] = latency.maxUs;
+        return out;
+    }
+};
+
+// Bien dem theo tung peer cua Comm, chi so la id peer. Chi gom phan Comm tu do duoc;
+// do sau hang doi va loi ket noi lay tu Outbox / Transport khi doc (Comm::getPeerStats).
+class PeerMetrics {
+private:
+    struct Counters {
+        std::atomic<uint64_t> messagesSent{0};
+        std::atomic<uint64_t> bytesSent{0};
+        std::atomic<uint64_t> sendErrors{0};
+        std::atomic<uint64_t> messagesReceived{0};
+        std::atomic<uint64_t> bytesReceived{0};
+        LatencyHistogram latency;
+    };
+
+    std::vector<std::unique_ptr<Counters>> peers;
+
+public:
+    explicit PeerMetrics(int totalNodes) {
+        for (int i = 0; i <= totalNodes; i++) {
+            peers.push_back(std::make_unique<Counters>());
+        }
+    }
+
+    void sent(int peerId, size_t bytes, bool ok) {
+        Counters *c = find(peerId);
+        if (c == nullptr) {
+            return;
+        }
+        if (ok) {
+            c->messagesSent.fetch_add(1, std::memory_order_relaxed);
+            c->bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+        } else {
+            c->sendErrors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // sentNs = 0 hoac lon hon hien tai (lech dong ho) thi khong lay mau do tre
+    void received(int peerId, size_t bytes, uint64_t sentNs, uint64_t nowNs) {
+        Counters *c = find(peerId);
+        if (c == nullptr) {
+            return;
+        }
+        c->messagesReceived.fetch_add(1, std::memory_order_relaxed);
+        c->bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+        if (sentNs != 0 && sentNs <= nowNs) {
+            c->latency.record((nowNs - sentNs) / 1000);
+        }
+    }
+
+    // phan do Comm dem; cac truong con lai bang 0
+    PeerStats snapshot(int peerId) const {
+        const Counters *c = peerId > 0 && peerId < static_cast<int>(peers.size()) ? peers[peerId].get() : nullptr;
+        if (c == nullptr) {
+            return PeerStats{peerId, 0, 0, 0, 0, 0, 0, 0, 0, LatencyStats{0, 0, 0, 0, 0, {}}};
+        }
+        return PeerStats{peerId, c->messagesSent.load(), c->bytesSent.load(), c->sendErrors.load(), 0, 0, 0,
+                         c->messagesReceived.load(), c->bytesReceived.load(), c->latency.snapshot()};
+    }
+
+private:
+    Counters *find(int peerId) {
+        if (peerId <= 0 || peerId >= static_cast<int>(peers.size())) {
+            return nullptr;
+        }
+        return peers[peerId].get();
+    }
+};
+
+#endif // METRICS_H
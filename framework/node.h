@@ -7,6 +7,7 @@
 #include <map>
 #include <thread>
 #include "comm.h"
+#include "dispatch.h"
 #include "config.h"
 #include "log.h"
 
@@ -23,6 +24,11 @@ public:
     
     virtual ~Node() = default;
     virtual void initialize() = 0;
+
+    // so ban tin da xu ly / bi bo qua cua bang dieu phoi (dispatch.h)
+    virtual DispatchStats getDispatchStats() const {
+        return DispatchStats{0, 0, 0};
+    }
 };
 
 class TokenBasedNode : public Node {
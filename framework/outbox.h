@@ -0,0 +1,210 @@
+// outbox.h
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include "executor.h"
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+
+struct OutboxStats {
+    size_t depth;               // so ban tin dang cho gui (tat ca peer)
+    size_t highWater;           // do sau lon nhat cua mot hang doi peer
+    uint64_t queued;            // so ban tin da dua vao hang doi
+    uint64_t dropped;           // so ban tin bi bo vi hang doi cua peer da day
+    uint64_t sent;              // so ban tin da lay ra gui
+    uint64_t totalWaitNs;       // tong thoi gian ban tin nam trong hang doi
+    uint64_t maxWaitNs;
+
+    double averageWaitUs() const {
+        return sent == 0 ? 0.0 : totalWaitNs / 1000.0 / sent;
+    }
+};
+
+struct OutboxPeerStats {
+    size_t depth;
+    uint64_t dropped;
+};
+
+// Hang doi gui rieng cho tung peer. push chi dua ban tin vao hang doi roi tra ve ngay;
+// luong I/O cua peer (IoWorkers, chon theo id) lay ban tin ra va goi transport. Moi
+// peer chi co mot lan rut hang doi dang chay nen thu tu FIFO toi moi dich duoc giu.
+// Hang doi co gioi han: peer cham/chet lam day hang doi thi ban tin moi bi bo va dem lai.
+// Moi peer co mot hang doi cho tung lan uu tien (lan 0 cao nhat, gioi han rieng tung lan):
+// lan rut luon lay lan cao nhat con ban tin, moi lan toi da DRAIN_BATCH ban tin, nen ban
+// tin dieu khien chi phai cho mot lo nho ban tin lan thap dang gui do. FIFO giu trong lan.
+class Outbox {
+public:
+    typedef std::function<bool(int, const std::string &)> Sender;
+    typedef std::function<void(bool)> Done;      // goi sau khi gui (true = thanh cong)
+
+    static const size_t DRAIN_BATCH = 32;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Item {
+        std::shared_ptr<const std::string> message;
+        Done done;
+        Clock::time_point enqueued;
+    };
+
+    struct Queue {
+        std::mutex mtx;
+        std::vector<std::deque<Item>> lanes;
+        bool draining = false;
+        std::atomic<size_t> depth{0};           // doc khong can khoa (metrics theo peer)
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    struct LaneCounters {
+        std::atomic<size_t> depth{0};
+        std::atomic<size_t> highWater{0};
+        std::atomic<uint64_t> queued{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> totalWaitNs{0};
+        std::atomic<uint64_t> maxWaitNs{0};
+    };
+
+    Sender sender;
+    size_t limit;
+    std::vector<std::unique_ptr<Queue>> queues;     // chi so la id peer
+    std::vector<std::unique_ptr<LaneCounters>> counters;
+    IoWorkers workers;                              // huy truoc queues: gui not phan con lai
+
+public:
+    Outbox(int totalNodes, size_t workerCount, size_t limit, Sender sender, size_t laneCount = 1)
+        : sender(sender), limit(limit), workers(workerCount) {
+        for (int i = 0; i <= totalNodes; i++) {
+            queues.push_back(std::make_unique<Queue>());
+            queues.back()->lanes.resize(laneCount);
+        }
+        for (size_t i = 0; i < laneCount; i++) {
+            counters.push_back(std::make_unique<LaneCounters>());
+        }
+    }
+
+    // tra ve false neu peer khong ton tai hoac hang doi da day (done duoc goi voi false)
+    bool push(int dest, size_t lane, std::shared_ptr<const std::string> message, Done done = nullptr) {
+        if (dest <= 0 || dest >= static_cast<int>(queues.size())) {
+            if (done) {
+                done(false);
+            }
+            return false;
+        }
+        lane = lane < counters.size() ? lane : counters.size() - 1;
+        Queue &queue = *queues[dest];
+        LaneCounters &counter = *counters[lane];
+        bool startDrain = false;
+        {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            std::deque<Item> &items = queue.lanes[lane];
+            if (items.size() >= limit) {
+                counter.dropped++;
+                queue.dropped++;
+            } else {
+                items.push_back(Item{std::move(message), std::move(done), Clock::now()});
+                size_t size = items.size();
+                size_t seen = counter.highWater.load(std::memory_order_relaxed);
+                while (size > seen && !counter.highWater.compare_exchange_weak(seen, size, std::memory_order_relaxed)) {}
+                counter.depth++;
+                queue.depth++;
+                counter.queued++;
+                startDrain = !queue.draining;
+                queue.draining = true;
+                done = nullptr;
+            }
+        }
+        if (done) {
+            done(false);
+            return false;
+        }
+        if (startDrain) {
+            workers.post(dest, [this, dest]() { drain(dest); });
+        }
+        return true;
+    }
+
+    // tong cua tat ca lan
+    OutboxStats getStats() const {
+        OutboxStats stats{0, 0, 0, 0, 0, 0, 0};
+        for (size_t lane = 0; lane < counters.size(); lane++) {
+            OutboxStats one = getStats(lane);
+            stats.depth += one.depth;
+            stats.highWater = std::max(stats.highWater, one.highWater);
+            stats.queued += one.queued;
+            stats.dropped += one.dropped;
+            stats.sent += one.sent;
+            stats.totalWaitNs += one.totalWaitNs;
+            stats.maxWaitNs = std::max(stats.maxWaitNs, one.maxWaitNs);
+        }
+        return stats;
+    }
+
+    OutboxStats getStats(size_t lane) const {
+        if (lane >= counters.size()) {
+            return OutboxStats{0, 0, 0, 0, 0, 0, 0};
+        }
+        const LaneCounters &c = *counters[lane];
+        return OutboxStats{c.depth.load(), c.highWater.load(), c.queued.load(), c.dropped.load(),
+                           c.sent.load(), c.totalWaitNs.load(), c.maxWaitNs.load()};
+    }
+
+    // do sau hang doi va so ban tin bi bo cua mot peer
+    OutboxPeerStats getPeerStats(int dest) const {
+        if (dest <= 0 || dest >= static_cast<int>(queues.size())) {
+            return OutboxPeerStats{0, 0};
+        }
+        return OutboxPeerStats{queues[dest]->depth.load(), queues[dest]->dropped.load()};
+    }
+
+private:
+    // lay mot lo ban tin cua lan cao nhat con ban tin ra khoi khoa roi moi gui
+    void drain(int dest) {
+        Queue &queue = *queues[dest];
+        std::vector<Item> batch;
+        batch.reserve(DRAIN_BATCH);
+        while (true) {
+            size_t lane = 0;
+            {
+                std::lock_guard<std::mutex> lock(queue.mtx);
+                while (lane < queue.lanes.size() && queue.lanes[lane].empty()) {
+                    lane++;
+                }
+                if (lane == queue.lanes.size()) {
+                    queue.draining = false;
+                    return;
+                }
+                std::deque<Item> &items = queue.lanes[lane];
+                while (!items.empty() && batch.size() < DRAIN_BATCH) {
+                    batch.push_back(std::move(items.front()));
+                    items.pop_front();
+                }
+            }
+            LaneCounters &counter = *counters[lane];
+            for (auto &item : batch) {
+                uint64_t wait = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - item.enqueued).count();
+                counter.totalWaitNs += wait;
+                uint64_t seen = counter.maxWaitNs.load(std::memory_order_relaxed);
+                while (wait > seen && !counter.maxWaitNs.compare_exchange_weak(seen, wait, std::memory_order_relaxed)) {}
+                counter.sent++;
+                bool ok = sender(dest, *item.message);
+                counter.depth--;
+                queue.depth--;
+                if (item.done) {
+                    item.done(ok);
+                }
+            }
+            batch.clear();
+        }
+    }
+};
+
+#endif // OUTBOX_H
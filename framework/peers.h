@@ -0,0 +1,100 @@
+// peers.h
+#ifndef PEERS_H
+#define PEERS_H
+
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/un.h>
+#include <ifaddrs.h>
+#include <arpa/inet.h>
+
+// Ten socket AF_UNIX (abstract namespace) cua node lang nghe tren port
+inline socklen_t unixAddress(int port, sockaddr_un &addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::string name = "dme." + std::to_string(port);
+    memcpy(addr.sun_path + 1, name.data(), name.size());
+    return offsetof(sockaddr_un, sun_path) + 1 + name.size();
+}
+
+// Cac dia chi IPv4 cua may nay, dung de nhan ra peer chay cung may
+inline std::set<std::string> localAddresses() {
+    std::set<std::string> addresses;
+    struct ifaddrs *ifaddr;
+    if (getifaddrs(&ifaddr) < 0) {
+        return addresses;
+    }
+    for (struct ifaddrs *ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET) {
+            continue;
+        }
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &((sockaddr_in*)ifa->ifa_addr)->sin_addr, ip, sizeof(ip));
+        addresses.insert(ip);
+    }
+    freeifaddrs(ifaddr);
+    return addresses;
+}
+
+inline bool isLocalAddress(const std::string &ip, const std::set<std::string> &local) {
+    return ip.rfind("127.", 0) == 0 || ip == "localhost" || local.count(ip);
+}
+
+// Dia chi cua mot peer da phan giai san, dung thang tren duong gui
+struct PeerAddress {
+    int id = 0;                 // 0: khong co peer nay
+    std::string ip;
+    int port = 0;
+    bool local = false;         // peer chay cung may (dung AF_UNIX duoc)
+    sockaddr_in inetAddr;
+    sockaddr_un unixAddr;
+    socklen_t unixLength = 0;
+};
+
+// Bang dia chi cua tat ca peer, chi so la id node. Bang khong bao gio bi sua: doi dia chi
+// thi Config::updatePeers dung bang moi va thay ca con tro, nguoi doc giu shared_ptr cua bang
+// cu nen doc khong can khoa. Cac transport cap phat trang thai theo peer mot lan tu size()
+// cua bang luc khoi dong.
+class PeerTable {
+private:
+    std::vector<PeerAddress> entries;
+
+public:
+    explicit PeerTable(const std::map<int, std::pair<std::string, int>> &nodes) {
+        int maxId = nodes.empty() ? 0 : nodes.rbegin()->first;
+        entries.resize(maxId + 1);
+        std::set<std::string> local = localAddresses();
+        for (auto &[peerId, address] : nodes) {
+            PeerAddress &entry = entries[peerId];
+            entry.id = peerId;
+            entry.ip = address.first;
+            entry.port = address.second;
+            entry.local = isLocalAddress(address.first, local);
+            memset(&entry.inetAddr, 0, sizeof(entry.inetAddr));
+            entry.inetAddr.sin_family = AF_INET;
+            entry.inetAddr.sin_port = htons(address.second);
+            inet_pton(AF_INET, address.first.c_str(), &entry.inetAddr.sin_addr);
+            entry.unixLength = unixAddress(address.second, entry.unixAddr);
+        }
+    }
+
+    // nullptr neu khong co peer
+    const PeerAddress *find(int peerId) const {
+        if (peerId <= 0 || peerId >= static_cast<int>(entries.size()) || entries[peerId].id == 0) {
+            return nullptr;
+        }
+        return &entries[peerId];
+    }
+
+    // id lon nhat + 1, dung de cap phat mang theo id
+    int size() const {
+        return static_cast<int>(entries.size());
+    }
+};
+
+#endif // PEERS_H
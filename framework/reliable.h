@@ -0,0 +1,505 @@
+// reliable.h
+#ifndef RELIABLE_H
+#define RELIABLE_H
+
+#include "transport.h"
+#include "outbox.h"
+#include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <thread>
+#include <condition_variable>
+#include <endian.h>
+
+// Trang thai tin cay cua mot kenh toi mot peer: so thu tu, bao nhan chon loc (SACK),
+// truyen lai theo timer va loai bo ban tin trung. Moi goi DATA mang theo base: seq nho
+// nhat ben gui con giu (moi seq nho hon da duoc bao nhan hoac da bo), nho vay ben nhan
+// vua khoi dong lai (hoac ben gui da bo mot ban tin) khong phai cho nhung seq se khong
+// bao gio den nua. Lop nay khong tu khoa, nguoi goi phai bao ve bang mutex cua peer.
+class ReliableLink {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const uint32_t WINDOW = 64;                  // so ban tin toi da giu lai khi den sai thu tu
+    static const int MAX_RETRIES = 8;
+
+private:
+    struct Pending {
+        std::string packet;
+        Clock::time_point sentAt;
+        Clock::time_point deadline;
+        std::chrono::milliseconds rto;
+        int retries = 0;
+    };
+
+    int maxRetries;
+    std::chrono::milliseconds maxRto;
+
+    // phia gui
+    uint32_t session;
+    uint32_t nextSeq = 1;
+    std::map<uint32_t, Pending> unacked;
+    std::chrono::microseconds srtt{0};
+
+    // phia nhan
+    uint32_t peerSession = 0;
+    uint32_t expected = 1;                              // so thu tu tiep theo can giao cho Comm
+    std::map<uint32_t, Buffer> outOfOrder;
+
+public:
+    ReliableLink(int maxRetries = MAX_RETRIES, std::chrono::milliseconds maxRto = std::chrono::milliseconds(2000))
+        : maxRetries(maxRetries), maxRto(maxRto) {
+        std::random_device rd;
+        session = rd() | 1;
+    }
+
+    uint32_t getSession() const {
+        return session;
+    }
+
+    uint32_t nextSequence() {
+        return nextSeq++;
+    }
+
+    // base cho goi DATA sap gui: goi truoc nextSequence()
+    uint32_t lowestUnacked() const {
+        return unacked.empty() ? nextSeq : unacked.begin()->first;
+    }
+
+    size_t inFlight() const {
+        return unacked.size();
+    }
+
+    // luu lai goi tin da gui de truyen lai neu khong duoc bao nhan
+    void track(uint32_t seq, std::string packet, Clock::time_point now) {
+        Pending &p = unacked[seq];
+        p.packet = std::move(packet);
+        p.sentAt = now;
+        p.rto = currentRto();
+        p.deadline = now + p.rto;
+    }
+
+    // cumulative: moi ban tin co seq < cumulative da den; bit i cua sack: seq = cumulative + 1 + i da den
+    void acked(uint32_t ackSession, uint32_t cumulative, uint64_t sack, Clock::time_point now) {
+        if (ackSession != session) {
+            return;
+        }
+        auto it = unacked.begin();
+        while (it != unacked.end()) {
+            uint32_t seq = it->first;
+            bool done = seq < cumulative;
+            if (!done && seq > cumulative && seq - cumulative - 1 < 64) {
+                done = (sack >> (seq - cumulative - 1)) & 1;
+            }
+            if (done) {
+                if (it->second.retries == 0) {
+                    sampleRtt(now - it->second.sentAt);
+                }
+                it = unacked.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // cac goi tin da qua han can truyen lai; goi tin vuot qua MAX_RETRIES duoc dua vao expired
+    std::vector<std::string *> due(Clock::time_point now, std::vector<std::string> &expired) {
+        std::vector<std::string *> packets;
+        auto it = unacked.begin();
+        while (it != unacked.end()) {
+            Pending &p = it->second;
+            if (p.deadline > now) {
+                ++it;
+                continue;
+            }
+            if (p.retries >= maxRetries) {
+                expired.push_back(std::move(p.packet));
+                it = unacked.erase(it);
+                continue;
+            }
+            p.retries++;
+            p.rto = std::min(p.rto * 2, maxRto);
+            p.deadline = now + p.rto;
+            packets.push_back(&p.packet);
+            ++it;
+        }
+        return packets;
+    }
+
+    // nhan mot ban tin du lieu; cac ban tin da du thu tu duoc them vao ready.
+    // base = 0: ben gui khong gui kem base. Tra ve false neu day la ban tin trung
+    // hoac nam ngoai cua so.
+    bool receive(uint32_t fromSession, uint32_t seq, Buffer payload, std::vector<Buffer> &ready, uint32_t base = 0) {
+        if (fromSession != peerSession) {
+            // peer khoi dong lai: bat dau phien moi
+            peerSession = fromSession;
+            expected = 1;
+            outOfOrder.clear();
+        }
+        base = std::min(base, seq);
+        if (base > expected) {
+            // cac seq truoc base se khong den nua; giao cac ban tin da giu truoc base roi bo qua cho trong
+            auto it = outOfOrder.begin();
+            while (it != outOfOrder.end() && it->first < base) {
+                ready.push_back(std::move(it->second));
+                it = outOfOrder.erase(it);
+            }
+            expected = base;
+        }
+        if (seq < expected || outOfOrder.count(seq) || seq - expected >= WINDOW) {
+            return false;
+        }
+        outOfOrder.emplace(seq, std::move(payload));
+        auto it = outOfOrder.begin();
+        while (it != outOfOrder.end() && it->first == expected) {
+            ready.push_back(std::move(it->second));
+            it = outOfOrder.erase(it);
+            expected++;
+        }
+        return true;
+    }
+
+    uint32_t getPeerSession() const {
+        return peerSession;
+    }
+
+    uint32_t ackCumulative() const {
+        return expected;
+    }
+
+    uint64_t ackBitmap() const {
+        uint64_t sack = 0;
+        for (auto &[seq, payload] : outOfOrder) {
+            if (seq - expected - 1 < 64) {
+                sack |= 1ULL << (seq - expected - 1);
+            }
+        }
+        return sack;
+    }
+
+private:
+    std::chrono::milliseconds currentRto() const {
+        if (srtt.count() == 0) {
+            return std::chrono::milliseconds(50);
+        }
+        auto rto = std::chrono::duration_cast<std::chrono::milliseconds>(srtt * 3);
+        return std::max(rto, std::chrono::milliseconds(10));
+    }
+
+    void sampleRtt(Clock::duration rtt) {
+        auto sample = std::chrono::duration_cast<std::chrono::microseconds>(rtt);
+        srtt = srtt.count() == 0 ? sample : (srtt * 7 + sample) / 8;
+    }
+};
+
+// Phia tin cay dung chung cua UdpTransport va ReliableTransport: mot ReliableLink cho moi
+// peer, dinh dang goi tin va vong ACK / truyen lai. Transport chi lo dua goi tin di.
+//   DATA: type | source | session | seq | base | payload
+//   ACK:  type | source | session cua ben gui DATA | cumulative | sack
+// So nguyen theo big-endian.
+class ReliableEndpoint {
+public:
+    typedef ReliableLink::Clock Clock;
+
+    enum PacketType : uint8_t { DATA = 1, ACK = 2 };
+    enum Received { IGNORED, DELIVERED, DUPLICATE, ACKED };
+
+    static const size_t DATA_HEADER = 17;
+    static const size_t ACK_SIZE = 21;
+    static constexpr int TICK_MS = 5;
+
+    // goi tin flush() tra ve cho transport gui
+    struct Outgoing {
+        int peerId;
+        PacketType type;
+        std::string packet;
+    };
+
+private:
+    struct Peer {
+        int id;
+        ReliableLink link;
+        bool needAck = false;
+        std::mutex mtx;
+
+        Peer(int id, int maxRetries, std::chrono::milliseconds maxRto) : id(id), link(maxRetries, maxRto) {}
+    };
+
+    int id;
+    std::vector<std::unique_ptr<Peer>> peers;       // chi so la id
+    Clock::time_point lastTick;                     // chi luong goi flush() dung
+
+public:
+    ReliableEndpoint(int id, int maxRetries, std::chrono::milliseconds maxRto) : id(id), lastTick(Clock::now()) {
+        std::shared_ptr<const PeerTable> table = config.getPeers();
+        peers.resize(table->size());
+        for (int peerId = 1; peerId < table->size(); peerId++) {
+            if (table->find(peerId) != nullptr) {
+                peers[peerId] = std::make_unique<Peer>(peerId, maxRetries, maxRto);
+            }
+        }
+    }
+
+    // danh so ban tin, giu lai de truyen lai va ghi goi DATA vao packet; false neu khong co peer
+    bool data(int destId, const std::string &message, Clock::time_point now, std::string &packet) {
+        Peer *peer = find(destId);
+        if (peer == nullptr) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(peer->mtx);
+        uint32_t base = peer->link.lowestUnacked();
+        uint32_t seq = peer->link.nextSequence();
+        packet = encodeData(peer->link.getSession(), seq, base, message);
+        peer->link.track(seq, packet, now);
+        return true;
+    }
+
+    // xu ly mot goi nhan duoc; ban tin du thu tu duoc them vao ready. payload() tra ve Buffer
+    // chua phan sau DATA_HEADER, chi duoc goi sau khi da doc xong header tu data
+    template <typename Payload>
+    Received receive(const char *data, size_t size, Payload payload, std::vector<Buffer> &ready) {
+        if (size >= DATA_HEADER && static_cast<uint8_t>(data[0]) == DATA) {
+            Peer *peer = find(get32(data + 1));
+            if (peer == nullptr) {
+                return IGNORED;
+            }
+            uint32_t session = get32(data + 5);
+            uint32_t seq = get32(data + 9);
+            uint32_t base = get32(data + 13);
+            std::lock_guard<std::mutex> lock(peer->mtx);
+            peer->needAck = true;
+            return peer->link.receive(session, seq, payload(), ready, base) ? DELIVERED : DUPLICATE;
+        }
+        if (size >= ACK_SIZE && static_cast<uint8_t>(data[0]) == ACK) {
+            Peer *peer = find(get32(data + 1));
+            if (peer == nullptr) {
+                return IGNORED;
+            }
+            uint64_t sack;
+            memcpy(&sack, data + 13, 8);
+            std::lock_guard<std::mutex> lock(peer->mtx);
+            peer->link.acked(get32(data + 5), get32(data + 9), be64toh(sack), Clock::now());
+            return ACKED;
+        }
+        return IGNORED;
+    }
+
+    // mot ACK cho moi peer vua gui du lieu, va moi TICK_MS cac goi qua han can truyen lai.
+    // failed nhan (peer, so ban tin) da het so lan truyen lai. Tra ve so goi truyen lai
+    size_t flush(Clock::time_point now, std::vector<Outgoing> &out, std::vector<std::pair<int, size_t>> &failed) {
+        bool tick = now - lastTick >= std::chrono::milliseconds(TICK_MS);
+        if (tick) {
+            lastTick = now;
+        }
+        size_t resent = 0;
+        for (auto &peer : peers) {
+            if (!peer) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(peer->mtx);
+            if (peer->needAck) {
+                peer->needAck = false;
+                out.push_back({peer->id, ACK, encodeAck(peer->link.getPeerSession(), peer->link.ackCumulative(), peer->link.ackBitmap())});
+            }
+            if (!tick || peer->link.inFlight() == 0) {
+                continue;
+            }
+            std::vector<std::string> expired;
+            for (std::string *packet : peer->link.due(now, expired)) {
+                out.push_back({peer->id, DATA, *packet});
+                resent++;
+            }
+            if (!expired.empty()) {
+                failed.emplace_back(peer->id, expired.size());
+            }
+        }
+        return resent;
+    }
+
+private:
+    Peer *find(uint32_t peerId) {
+        return peerId < peers.size() ? peers[peerId].get() : nullptr;
+    }
+
+    static void put32(std::string &out, uint32_t value) {
+        value = htonl(value);
+        out.append(reinterpret_cast<const char *>(&value), 4);
+    }
+
+    static uint32_t get32(const char *data) {
+        uint32_t value;
+        memcpy(&value, data, 4);
+        return ntohl(value);
+    }
+
+    std::string encodeData(uint32_t session, uint32_t seq, uint32_t base, const std::string &message) const {
+        std::string packet;
+        packet.reserve(DATA_HEADER + message.size());
+        packet.push_back(static_cast<char>(DATA));
+        put32(packet, id);
+        put32(packet, session);
+        put32(packet, seq);
+        put32(packet, base);
+        packet.append(message);
+        return packet;
+    }
+
+    std::string encodeAck(uint32_t session, uint32_t cumulative, uint64_t sack) const {
+        std::string packet;
+        packet.reserve(ACK_SIZE);
+        packet.push_back(static_cast<char>(ACK));
+        put32(packet, id);
+        put32(packet, session);
+        put32(packet, cumulative);
+        uint64_t be = htobe64(sack);
+        packet.append(reinterpret_cast<const char *>(&be), 8);
+        return packet;
+    }
+};
+
+// Che do tin cay (RELIABLE=1) cho transport co ket noi (socket, uring): moi ban tin duoc
+// danh so va giu lai den khi peer bao nhan, qua han thi truyen lai voi backoff, het so lan
+// thi bao qua onFailure. Ben nhan loai bo ban tin trung va giao dung thu tu gui. Dinh dang
+// goi tin va vong ACK / truyen lai la cua ReliableEndpoint, giong het UdpTransport.
+// ACK va goi truyen lai di qua Outbox rieng (lan 0: ACK, lan 1: truyen lai) nen luong timer
+// khong bao gio phai cho transport ben duoi; hang doi day thi goi bi bo, lan sau gui lai.
+class ReliableTransport : public Transport {
+private:
+    static const size_t ACK_LANE = 0;
+    static const size_t RETRANSMIT_LANE = 1;
+
+    ReliableEndpoint endpoint;
+    std::unique_ptr<Transport> inner;
+    std::unique_ptr<Outbox> outbox;                 // huy truoc inner
+    Deliver deliver;
+    std::mutex timerMtx;
+    std::condition_variable timerCv;
+    bool ackPending = false;
+    bool stopping = false;
+    std::thread m_timerThread;
+
+public:
+    ReliableTransport(int id, std::unique_ptr<Transport> inner, int maxRetries, std::chrono::milliseconds maxRto)
+        : endpoint(id, maxRetries, maxRto), inner(std::move(inner)) {
+        outbox = std::make_unique<Outbox>(config.getTotalNodes(), config.getIoWorkers(), config.getSendQueueLimit(),
+            [this](int destId, const std::string &packet) { return this->inner->send(destId, packet); }, 2);
+    }
+
+    ~ReliableTransport() {
+        {
+            std::lock_guard<std::mutex> lock(timerMtx);
+            stopping = true;
+        }
+        timerCv.notify_one();
+        if (m_timerThread.joinable()) {
+            m_timerThread.join();
+        }
+        outbox.reset();
+        inner.reset();
+    }
+
+    std::string name() const override {
+        return "reliable/" + inner->name();
+    }
+
+    void start(Deliver deliver, BufferPool &pool) override {
+        this->deliver = deliver;
+        inner->start([this](std::vector<Buffer> &frames) { receive(frames); }, pool);
+        m_timerThread = std::thread(&ReliableTransport::timerThread, this);
+    }
+
+    // ban tin da duoc danh so thi coi nhu gui thanh cong; gui loi se duoc timer truyen lai
+    bool send(int destId, const std::string &message) override {
+        std::string packet;
+        if (!endpoint.data(destId, message, ReliableEndpoint::Clock::now(), packet)) {
+            return false;
+        }
+        messagesSent++;
+        inner->send(destId, packet);
+        return true;
+    }
+
+    bool preservesOrder() const override {
+        return true;
+    }
+
+    bool sendMayBlock() const override {
+        return inner->sendMayBlock();
+    }
+
+    std::string peerTransport(int peerId) override {
+        return "reliable/" + inner->peerTransport(peerId);
+    }
+
+    uint64_t connectFailures(int peerId) const override {
+        return inner->connectFailures(peerId);
+    }
+
+    CommStats getStats() const override {
+        CommStats stats = inner->getStats();
+        stats.retransmits += retransmits.load();
+        stats.duplicates += duplicates.load();
+        stats.deliveryFailures += deliveryFailures.load();
+        return stats;
+    }
+
+private:
+    // chay tren luong nhan cua transport ben duoi
+    void receive(std::vector<Buffer> &frames) {
+        std::vector<Buffer> ready;
+        bool needAck = false;
+        for (auto &frame : frames) {
+            ReliableEndpoint::Received received = endpoint.receive(frame.data(), frame.size(), [&frame]() {
+                frame.removePrefix(ReliableEndpoint::DATA_HEADER);
+                return std::move(frame);
+            }, ready);
+            if (received == ReliableEndpoint::DUPLICATE) {
+                duplicates++;
+            }
+            needAck = needAck || received == ReliableEndpoint::DELIVERED || received == ReliableEndpoint::DUPLICATE;
+        }
+        if (!ready.empty()) {
+            messagesReceived += ready.size();
+            deliver(ready);
+        }
+        if (needAck) {
+            // ACK duoc gui tu luong timer de luong nhan khong phai cho peer
+            {
+                std::lock_guard<std::mutex> lock(timerMtx);
+                ackPending = true;
+            }
+            timerCv.notify_one();
+        }
+    }
+
+    void timerThread() {
+        std::vector<ReliableEndpoint::Outgoing> out;
+        std::vector<std::pair<int, size_t>> failed;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(timerMtx);
+                timerCv.wait_for(lock, std::chrono::milliseconds(ReliableEndpoint::TICK_MS),
+                                 [this]() { return stopping || ackPending; });
+                if (stopping) {
+                    return;
+                }
+                ackPending = false;
+            }
+            retransmits += endpoint.flush(ReliableEndpoint::Clock::now(), out, failed);
+            for (auto &packet : out) {
+                size_t lane = packet.type == ReliableEndpoint::ACK ? ACK_LANE : RETRANSMIT_LANE;
+                outbox->push(packet.peerId, lane, std::make_shared<const std::string>(std::move(packet.packet)));
+            }
+            for (auto &[peerId, count] : failed) {
+                reportFailure(peerId, count);
+            }
+            out.clear();
+            failed.clear();
+        }
+    }
+};
+
+#endif // RELIABLE_H
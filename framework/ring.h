@@ -0,0 +1,272 @@
+// ring.h
+#ifndef RING_H
+#define RING_H
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Hang doi vong co gioi han, khong khoa, nhieu luong ghi - mot luong doc
+// (thuat toan bounded queue cua D. Vyukov). Dung lam hop thu den cua moi node.
+template <typename T>
+class MpscRing {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::vector<Cell> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};   // chi luong doc thay doi
+
+public:
+    // capacity duoc lam tron len luy thua cua 2
+    explicit MpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buffer = std::vector<Cell>(size);
+        for (size_t i = 0; i < size; i++) {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask = size - 1;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // tra ve false neu hang doi da day
+    bool push(T &&value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (1) {
+            Cell &cell = buffer[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // chi mot luong duoc goi pop
+    bool pop(T &value) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = buffer[pos & mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) {
+            return false;
+        }
+        value = std::move(cell.data);
+        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // so phan tu xap xi (co the lech khi dang co luong ghi)
+    size_t size() const {
+        size_t tail = dequeuePos.load(std::memory_order_relaxed);
+        size_t head = enqueuePos.load(std::memory_order_relaxed);
+        return head >= tail ? head - tail : 0;
+    }
+};
+
+struct InboxStats {
+    size_t depth;               // so ban tin dang cho
+    size_t highWater;           // do sau lon nhat tung gap
+    uint64_t delivered;         // so ban tin da giao cho thuat toan
+    uint64_t totalWaitNs;       // tong thoi gian ban tin nam trong hop thu
+    uint64_t maxWaitNs;
+    uint64_t parks;             // so lan luong doc phai ngu
+
+    double averageWaitUs() const {
+        return delivered == 0 ? 0.0 : totalWaitNs / 1000.0 / delivered;
+    }
+};
+
+// Hop thu den cua mot node: moi lan uu tien mot MpscRing, cho doi kieu futex chung khi
+// tat ca deu rong. Luong ghi chi goi system call khi luong doc dang ngu. Luong doc luon
+// lay het lan so nho hon truoc (lan 0 cao nhat); thu tu FIFO chi giu trong tung lan.
+template <typename T>
+class Inbox {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        T value;
+        Clock::time_point enqueued;
+    };
+
+    struct Lane {
+        MpscRing<Entry> ring;
+        std::atomic<size_t> highWater{0};
+        // chi luong doc cap nhat
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> totalWaitNs{0};
+        std::atomic<uint64_t> maxWaitNs{0};
+
+        explicit Lane(size_t capacity) : ring(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Lane>> lanes;
+    alignas(64) std::atomic<uint32_t> sleeping{0};
+    std::atomic<uint64_t> parks{0};
+
+public:
+    explicit Inbox(size_t capacity, size_t laneCount = 1) {
+        for (size_t i = 0; i < laneCount; i++) {
+            lanes.push_back(std::make_unique<Lane>(capacity));
+        }
+    }
+
+    // hang doi day thi nhuong CPU cho den khi luong doc lay bot
+    void push(T &&value, size_t lane = 0) {
+        while (!tryPush(std::move(value), lane)) {
+            wake();
+            std::this_thread::yield();
+        }
+    }
+
+    // khong cho: lan da day thi tra ve false va value giu nguyen
+    bool tryPush(T &&value, size_t lane = 0) {
+        Lane &target = *lanes[lane < lanes.size() ? lane : lanes.size() - 1];
+        Entry entry{std::move(value), Clock::now()};
+        if (!target.ring.push(std::move(entry))) {
+            value = std::move(entry.value);
+            return false;
+        }
+        size_t depth = target.ring.size();
+        size_t seen = target.highWater.load(std::memory_order_relaxed);
+        while (depth > seen && !target.highWater.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {}
+        wake();
+        return true;
+    }
+
+    // cho den khi co ban tin
+    void pop(T &value) {
+        Entry entry;
+        size_t lane;
+        while (!popFirst(entry, lane)) {
+            park();
+        }
+        account(*lanes[lane], entry, Clock::now());
+        value = std::move(entry.value);
+    }
+
+    // cho den khi co it nhat mot ban tin roi lay toi da max ban tin, lan cao truoc
+    size_t popMany(std::vector<T> &out, size_t max) {
+        out.clear();
+        Entry entry;
+        size_t first;
+        while (!popFirst(entry, first)) {
+            park();
+        }
+        auto now = Clock::now();
+        account(*lanes[first], entry, now);
+        out.push_back(std::move(entry.value));
+        for (size_t lane = first; lane < lanes.size() && out.size() < max; lane++) {
+            while (out.size() < max && lanes[lane]->ring.pop(entry)) {
+                account(*lanes[lane], entry, now);
+                out.push_back(std::move(entry.value));
+            }
+        }
+        return out.size();
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (auto &lane : lanes) {
+            total += lane->ring.size();
+        }
+        return total;
+    }
+
+    // tong cua tat ca lan
+    InboxStats getStats() const {
+        InboxStats stats{0, 0, 0, 0, 0, parks.load()};
+        for (auto &lane : lanes) {
+            InboxStats one = laneStats(*lane);
+            stats.depth += one.depth;
+            stats.highWater = std::max(stats.highWater, one.highWater);
+            stats.delivered += one.delivered;
+            stats.totalWaitNs += one.totalWaitNs;
+            stats.maxWaitNs = std::max(stats.maxWaitNs, one.maxWaitNs);
+        }
+        return stats;
+    }
+
+    // thoi gian cho cua rieng mot lan
+    InboxStats getStats(size_t lane) const {
+        if (lane >= lanes.size()) {
+            return InboxStats{0, 0, 0, 0, 0, 0};
+        }
+        InboxStats stats = laneStats(*lanes[lane]);
+        stats.parks = parks.load();
+        return stats;
+    }
+
+private:
+    bool popFirst(Entry &entry, size_t &lane) {
+        for (lane = 0; lane < lanes.size(); lane++) {
+            if (lanes[lane]->ring.pop(entry)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static InboxStats laneStats(const Lane &lane) {
+        return InboxStats{lane.ring.size(), lane.highWater.load(), lane.delivered.load(),
+                          lane.totalWaitNs.load(), lane.maxWaitNs.load(), 0};
+    }
+
+    static void account(Lane &lane, const Entry &entry, Clock::time_point now) {
+        uint64_t wait = std::chrono::duration_cast<std::chrono::nanoseconds>(now - entry.enqueued).count();
+        lane.delivered.store(lane.delivered.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        lane.totalWaitNs.store(lane.totalWaitNs.load(std::memory_order_relaxed) + wait, std::memory_order_relaxed);
+        if (wait > lane.maxWaitNs.load(std::memory_order_relaxed)) {
+            lane.maxWaitNs.store(wait, std::memory_order_relaxed);
+        }
+    }
+
+    // bao cho luong ghi biet roi ngu tren futex; kiem tra lai hang doi truoc khi ngu
+    // de khong bo lo ban tin vua duoc ghi
+    void park() {
+        sleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (size() == 0) {
+            parks.fetch_add(1, std::memory_order_relaxed);
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&sleeping), FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+        sleeping.store(0, std::memory_order_relaxed);
+    }
+
+    void wake() {
+        // fence: ban tin vua ghi phai thay duoc truoc khi doc co sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) == 1 && sleeping.exchange(0) == 1) {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&sleeping), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+    }
+};
+
+#endif // RING_H
@@ -0,0 +1,207 @@
+// sequence.h
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "buffer.h"
+
+// Phong bi dat truoc moi ban tin khi transport khong dam bao thu tu (socket, uring):
+//   magic(1) | source(4) | session(4) | seq(4) | ban tin
+// seq dem rieng cho tung cap (nguon, dich) va bat dau lai tu 0 moi khi nguon khoi dong
+// lai (session moi).
+struct SequenceHeader {
+    static const char MAGIC = 'Q';
+    static const size_t SIZE = 13;
+
+    uint32_t source;
+    uint32_t session;
+    uint32_t seq;
+
+    std::string wrap(const std::string &message) const {
+        std::string frame(SIZE + message.size(), '\0');
+        frame[0] = MAGIC;
+        put32(&frame[1], source);
+        put32(&frame[5], session);
+        put32(&frame[9], seq);
+        memcpy(&frame[SIZE], message.data(), message.size());
+        return frame;
+    }
+
+    // tra ve false neu frame khong co phong bi
+    bool unwrap(std::string_view frame) {
+        if (frame.size() < SIZE || frame[0] != MAGIC) {
+            return false;
+        }
+        source = get32(&frame[1]);
+        session = get32(&frame[5]);
+        seq = get32(&frame[9]);
+        return true;
+    }
+
+private:
+    static void put32(char *out, uint32_t value) {
+        out[0] = static_cast<char>(value >> 24);
+        out[1] = static_cast<char>(value >> 16);
+        out[2] = static_cast<char>(value >> 8);
+        out[3] = static_cast<char>(value);
+    }
+
+    static uint32_t get32(const char *in) {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(in);
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+};
+
+struct ReorderStats {
+    uint64_t inOrder;           // ban tin den dung thu tu
+    uint64_t reordered;         // ban tin den som, phai giu lai cho ban tin truoc
+    uint64_t duplicates;        // seq da giao, bi bo
+    uint64_t gaps;              // so lan bo qua seq bi mat (tran cua so hoac het thoi gian cho)
+    uint64_t malformed;         // frame khong co phong bi
+    size_t buffered;            // so ban tin dang giu
+    size_t highWater;           // so ban tin giu lon nhat cua mot nguon
+};
+
+// Bo dem sap xep lai cho tung nguon: chi giao ban tin khi da giao het cac seq truoc no.
+// Ban tin bi thieu qua lau (timeout) hoac giu qua nhieu ban tin (window) thi bo qua
+// cho trong de khong chan ca kenh. Timeout duoc kiem tra khi co ban tin toi va dinh ky
+// qua expire() (luong timer cua Comm), de ban tin dang giu khong bi ket khi nguon im lang.
+class ReorderBuffer {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Source {
+        std::mutex mtx;
+        bool known = false;
+        uint32_t session = 0;
+        uint32_t expected = 0;
+        std::map<uint32_t, Buffer> pending;
+        Clock::time_point waitingSince;
+    };
+
+    std::vector<std::unique_ptr<Source>> sources;   // chi so la id nguon
+    size_t window;
+    Clock::duration timeout;
+    std::atomic<uint64_t> inOrder{0};
+    std::atomic<uint64_t> reordered{0};
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> gaps{0};
+    std::atomic<uint64_t> malformed{0};
+    std::atomic<size_t> buffered{0};
+    std::atomic<size_t> highWater{0};
+
+public:
+    ReorderBuffer(int totalNodes, size_t window, std::chrono::milliseconds timeout)
+        : window(window), timeout(timeout) {
+        for (int i = 0; i <= totalNodes; i++) {
+            sources.push_back(std::make_unique<Source>());
+        }
+    }
+
+    // goi deliver(Buffer &&) cho tung ban tin san sang theo dung thu tu; deliver chay
+    // khi dang giu khoa cua nguon nen cac luong nhan khac khong chen ban tin vao giua
+    template <typename Deliver>
+    void receive(Buffer &&frame, Deliver deliver) {
+        SequenceHeader header;
+        if (!header.unwrap(frame.view()) || header.source == 0 || header.source >= sources.size()) {
+            malformed++;
+            return;
+        }
+        frame.removePrefix(SequenceHeader::SIZE);
+        Source &source = *sources[header.source];
+        std::lock_guard<std::mutex> lock(source.mtx);
+        if (!source.known || source.session != header.session) {
+            // nguon moi hoac vua khoi dong lai: bat dau tu seq nay
+            buffered -= source.pending.size();
+            source.pending.clear();
+            source.known = true;
+            source.session = header.session;
+            source.expected = header.seq;
+        }
+        int32_t distance = static_cast<int32_t>(header.seq - source.expected);
+        if (distance < 0 || source.pending.count(header.seq)) {
+            duplicates++;
+            return;
+        }
+        if (distance > 0) {
+            if (source.pending.empty()) {
+                source.waitingSince = Clock::now();
+            }
+            source.pending.emplace(header.seq, std::move(frame));
+            reordered++;
+            buffered++;
+            size_t depth = source.pending.size();
+            size_t seen = highWater.load(std::memory_order_relaxed);
+            while (depth > seen && !highWater.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {}
+            if (depth > window || Clock::now() - source.waitingSince > timeout) {
+                flush(source, deliver);
+            }
+            return;
+        }
+        inOrder++;
+        deliver(std::move(frame));
+        source.expected++;
+        release(source, deliver);
+    }
+
+    // giao het ban tin cua cac nguon da cho qua timeout
+    template <typename Deliver>
+    void expire(Deliver deliver) {
+        if (buffered.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        auto now = Clock::now();
+        for (auto &source : sources) {
+            std::lock_guard<std::mutex> lock(source->mtx);
+            if (!source->pending.empty() && now - source->waitingSince > timeout) {
+                flush(*source, deliver);
+            }
+        }
+    }
+
+    ReorderStats getStats() const {
+        return ReorderStats{inOrder.load(), reordered.load(), duplicates.load(), gaps.load(),
+                            malformed.load(), buffered.load(), highWater.load()};
+    }
+
+private:
+    // giao cac ban tin dang giu lien tiep voi expected
+    template <typename Deliver>
+    void release(Source &source, Deliver &deliver) {
+        auto it = source.pending.begin();
+        while (it != source.pending.end() && it->first == source.expected) {
+            deliver(std::move(it->second));
+            it = source.pending.erase(it);
+            source.expected++;
+            buffered--;
+        }
+        source.waitingSince = Clock::now();
+    }
+
+    // coi moi seq con thieu giua cac ban tin dang giu la da mat va giao het: neu chi bo
+    // qua cho trong dau tien, cac cho trong sau phai doi ban tin moi toi moi duoc xet lai
+    template <typename Deliver>
+    void flush(Source &source, Deliver &deliver) {
+        for (auto &[seq, message] : source.pending) {
+            if (seq != source.expected) {
+                gaps++;
+            }
+            deliver(std::move(message));
+            source.expected = seq + 1;
+        }
+        buffered -= source.pending.size();
+        source.pending.clear();
+    }
+};
+
+#endif // SEQUENCE_H
@@ -0,0 +1,115 @@
+// shm.h
+#ifndef SHM_H
+#define SHM_H
+
+#include "transport.h"
+#include "ring.h"
+
+// Diem nhan cua mot node: ham nhan cua Comm va pool cua node do
+struct ShmEndpoint {
+    Transport::Deliver deliver;
+    BufferPool *pool = nullptr;
+};
+
+// Danh ba cac node chay trong cung tien trinh: id -> diem nhan cua node.
+// Node dang ky khi Comm khoi dong transport va huy dang ky khi Comm bi huy.
+class ShmRegistry {
+private:
+    std::vector<std::atomic<const ShmEndpoint*>> receivers;
+
+public:
+    ShmRegistry(int totalNodes) : receivers(totalNodes + 1) {
+        for (auto &receiver : receivers) {
+            receiver.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    static ShmRegistry &instance() {
+        static ShmRegistry registry(config.getTotalNodes());
+        return registry;
+    }
+
+    void attach(int id, const ShmEndpoint *receiver) {
+        if (id <= 0 || id >= static_cast<int>(receivers.size())) {
+            throw std::runtime_error("Node " + std::to_string(id) + " not found");
+        }
+        const ShmEndpoint *expected = nullptr;
+        if (!receivers[id].compare_exchange_strong(expected, receiver)) {
+            throw std::runtime_error("Node " + std::to_string(id) + " already attached");
+        }
+    }
+
+    void detach(int id) {
+        receivers[id].store(nullptr, std::memory_order_release);
+    }
+
+    const ShmEndpoint *find(int id) const {
+        if (id <= 0 || id >= static_cast<int>(receivers.size())) {
+            return nullptr;
+        }
+        return receivers[id].load(std::memory_order_acquire);
+    }
+};
+
+// Transport trong bo nho cho nhieu node trong mot tien trinh: send goi thang ham nhan
+// cua Comm dich tren luong gui (kiem tra checksum, phan lan uu tien roi vao hop thu),
+// khong co socket hay system call. Luong gui co the dang giu khoa cua thuat toan nen
+// khong bao gio cho: hop thu dich day thi ban tin bi bo va send tra ve false.
+class ShmTransport : public Transport {
+private:
+    int id;
+    ShmEndpoint endpoint;
+
+public:
+    explicit ShmTransport(int id) : id(id) {}
+
+    ~ShmTransport() {
+        if (endpoint.deliver) {
+            ShmRegistry::instance().detach(id);
+        }
+    }
+
+    std::string name() const override {
+        return "shm";
+    }
+
+    void start(Deliver deliver, BufferPool &pool) override {
+        endpoint.deliver = deliver;
+        endpoint.pool = &pool;
+        ShmRegistry::instance().attach(id, &endpoint);
+    }
+
+    bool send(int destId, const std::string &message) override {
+        const ShmEndpoint *receiver = ShmRegistry::instance().find(destId);
+        if (receiver == nullptr) {
+            return false;
+        }
+        // khoi lay tu pool cua node nhan: ban tin song lau hon Comm cua node gui
+        thread_local std::vector<Buffer> batch;
+        batch.clear();
+        batch.push_back(receiver->pool->copy(message));
+        receiver->deliver(batch);
+        bool accepted = batch.back().empty();
+        batch.clear();
+        if (!accepted) {
+            return false;
+        }
+        messagesSent++;
+        return true;
+    }
+
+    // goi ham nhan chi la thao tac bo nho, khong can luong I/O
+    bool preservesOrder() const override {
+        return true;
+    }
+
+    bool sendMayBlock() const override {
+        return false;
+    }
+
+    bool deliverMayBlock() const override {
+        return false;
+    }
+};
+
+#endif // SHM_H
@@ -0,0 +1,741 @@
+// transport.h
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "config.h"
+#include "peers.h"
+#include "buffer.h"
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <iostream>
+#include <set>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/un.h>
+#include <ifaddrs.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <unordered_map>
+#include <thread>
+#include <unistd.h>
+#include <poll.h>
+#include <chrono>
+#include <arpa/inet.h>
+
+// Dong goi ban tin: moi frame gom 4 byte do dai (big-endian) va noi dung ban tin.
+// Mot ket noi co the mang nhieu frame lien tiep voi kich thuoc tuy y.
+const uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+inline std::string encodeFrame(const std::string &message) {
+    std::string frame(4 + message.size(), '\0');
+    uint32_t len = htonl(static_cast<uint32_t>(message.size()));
+    memcpy(&frame[0], &len, 4);
+    memcpy(&frame[4], message.data(), message.size());
+    return frame;
+}
+
+// Ghep lai cac frame tu luong byte nhan duoc, du lieu co the den theo tung doan bat ky.
+// Frame nam tron trong doan vua doc duoc chep thang tu bo dem doc vao khoi cua pool; chi
+// frame bi cat ngang giua hai lan doc moi duoc gom tam trong partial.
+class FrameDecoder {
+private:
+    std::string partial;            // phan dau cua frame dang do dang
+    const char *chunk = nullptr;    // doan vua doc, chi hop le cho toi khi next tra ve false
+    size_t chunkSize = 0;
+    bool corrupted = false;
+
+public:
+    // data phai con song cho toi khi next tra ve false
+    void feed(const char *data, size_t size) {
+        chunk = data;
+        chunkSize = size;
+    }
+
+    // lay ra mot frame hoan chinh vao khoi cua pool, tra ve false neu chua du du lieu
+    bool next(Buffer &message, BufferPool &pool) {
+        if (corrupted) {
+            return false;
+        }
+        uint32_t len;
+        if (!partial.empty()) {
+            if (!fill(4) || !frameLength(partial.data(), len) || !fill(4 + static_cast<size_t>(len))) {
+                return false;
+            }
+            message = pool.copy(partial.data() + 4, len);
+            partial.clear();
+            return true;
+        }
+        if (chunkSize < 4) {
+            stash();
+            return false;
+        }
+        if (!frameLength(chunk, len)) {
+            return false;
+        }
+        if (chunkSize - 4 < len) {
+            stash();
+            return false;
+        }
+        message = pool.copy(chunk + 4, len);
+        chunk += 4 + len;
+        chunkSize -= 4 + len;
+        return true;
+    }
+
+    bool isCorrupted() const {
+        return corrupted;
+    }
+
+private:
+    bool frameLength(const char *data, uint32_t &len) {
+        memcpy(&len, data, 4);
+        len = ntohl(len);
+        if (len > MAX_FRAME_SIZE) {
+            corrupted = true;
+            return false;
+        }
+        return true;
+    }
+
+    // frame do dang o cuoi doan vua doc: giu lai cho lan doc sau
+    void stash() {
+        partial.assign(chunk, chunkSize);
+        chunkSize = 0;
+    }
+
+    // bu them tu chunk vao partial cho du bytes; false neu chunk da het
+    bool fill(size_t bytes) {
+        if (partial.size() < bytes) {
+            size_t n = std::min(bytes - partial.size(), chunkSize);
+            partial.append(chunk, n);
+            chunk += n;
+            chunkSize -= n;
+        }
+        return partial.size() >= bytes;
+    }
+};
+
+struct CommStats {
+    uint64_t connects;          // so lan mo ket noi moi toi peer
+    uint64_t reconnects;        // so lan phai ket noi lai sau khi ket noi cu bi loi
+    uint64_t reused;            // so ban tin gui qua ket noi da co san
+    uint64_t syscalls;          // so system call cua transport (gui + nhan)
+    uint64_t messagesSent;
+    uint64_t messagesReceived;
+    uint64_t retransmits;       // so goi tin phai truyen lai (udp)
+    uint64_t duplicates;        // so ban tin trung bi loai bo
+    uint64_t deliveryFailures;  // so ban tin bi bo sau khi het so lan truyen lai
+    // hang doi gui cua Comm
+    uint64_t queuedSends;       // so ban tin da dua vao hang doi gui
+    uint64_t queueDrops;        // so ban tin bi bo vi hang doi gui cua peer da day
+    size_t queueDepth;          // so ban tin dang cho gui
+    size_t queueHighWater;      // do sau lon nhat cua mot hang doi peer
+    uint64_t corruptFrames;     // frame sai CRC32C bi bo
+    uint64_t inboxDrops;        // ban tin bi bo vi hop thu den day (transport khong duoc cho, vd shm)
+
+    double syscallsPerMessage() const {
+        uint64_t messages = messagesSent + messagesReceived;
+        return messages == 0 ? 0.0 : static_cast<double>(syscalls) / messages;
+    }
+};
+
+// Lop co so cho cac cach truyen tin cua Comm. Transport nhan ban tin tu mang, chep
+// vao khoi cua pool cua node (buffer.h) va chuyen len Comm qua ham deliver theo tung lo.
+// Ban tin Comm da nhan duoc chuyen di khoi lo; ban tin con lai trong lo la bi bo
+// (frame hong, hoac hop thu day khi deliverMayBlock() = false).
+class Transport {
+public:
+    typedef std::function<void(std::vector<Buffer> &)> Deliver;
+    typedef std::function<void(int, size_t)> Failure;      // peer, so ban tin khong gui duoc
+
+protected:
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> reconnects{0};
+    std::atomic<uint64_t> reused{0};
+    std::atomic<uint64_t> syscalls{0};
+    std::atomic<uint64_t> messagesSent{0};
+    std::atomic<uint64_t> messagesReceived{0};
+    std::atomic<uint64_t> retransmits{0};
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> deliveryFailures{0};
+
+private:
+    Failure failure;
+    std::mutex failureMtx;
+
+public:
+    virtual ~Transport() = default;
+    virtual std::string name() const = 0;
+    // pool do Comm so huu, song lau hon transport
+    virtual void start(Deliver deliver, BufferPool &pool) = 0;
+    virtual bool send(int destId, const std::string &message) = 0;
+
+    // gui cung mot ban tin toi nhieu dich, ket qua theo thu tu cua dests.
+    // Transport co the gop thanh mot lan goi he thong.
+    virtual std::vector<bool> sendMany(const std::vector<int> &dests, const std::string &message) {
+        std::vector<bool> results;
+        for (int dest : dests) {
+            results.push_back(send(dest, message));
+        }
+        return results;
+    }
+
+    // true neu ban tin toi moi peer luon den dung thu tu gui (Comm khong can danh so)
+    virtual bool preservesOrder() const {
+        return false;
+    }
+
+    // false neu send khong bao gio phai cho peer (Comm goi truc tiep, khong qua hang doi gui)
+    virtual bool sendMayBlock() const {
+        return true;
+    }
+
+    // false neu ham deliver chay tren luong cua node khac (shm): Comm bo ban tin khi hop
+    // thu day thay vi cho, tranh hai node gui cho nhau cung treo
+    virtual bool deliverMayBlock() const {
+        return true;
+    }
+
+    // cach truyen tin dang dung toi mot peer (vd: tcp / unix)
+    virtual std::string peerTransport(int) {
+        return name();
+    }
+
+    // so lan mo ket noi toi peer that bai (transport co ket noi)
+    virtual uint64_t connectFailures(int) const {
+        return 0;
+    }
+
+    // goi khi ban tin toi mot peer bi bo sau khi het so lan truyen lai (transport tin cay)
+    virtual void onFailure(Failure handler) {
+        std::lock_guard<std::mutex> lock(failureMtx);
+        failure = handler;
+    }
+
+    virtual CommStats getStats() const {
+        return CommStats{connects.load(), reconnects.load(), reused.load(),
+                         syscalls.load(), messagesSent.load(), messagesReceived.load(),
+                         retransmits.load(), duplicates.load(), deliveryFailures.load(), 0, 0, 0, 0, 0, 0};
+    }
+
+protected:
+    void reportFailure(int peerId, size_t count) {
+        deliveryFailures += count;
+        Failure handler;
+        {
+            std::lock_guard<std::mutex> lock(failureMtx);
+            handler = failure;
+        }
+        if (handler) {
+            handler(peerId, count);
+        }
+    }
+};
+
+// Ket noi lau dai toi tung peer, mo lazily va mo lai khi bi loi.
+// Peer chay cung may duoc ket noi qua AF_UNIX, peer khac may qua TCP.
+// Dia chi lay tu bang da phan giai san cua config (peers.h), trang thai ket noi
+// nam trong mang theo id nen tim peer tren duong gui chi la mot phep lay chi so.
+// Luong gui (luong I/O dung chung cho nhieu peer) khong bi mot peer giu lau: connect
+// khong chan voi han CONNECT_TIMEOUT_MS, moi lan ghi cung bi gioi han boi SO_SNDTIMEO,
+// va peer connect bi qua han (mat goi, may chet) bi bo qua - send that bai ngay - trong
+// mot khoang backoff tang dan. Connect bi tu choi (peer dang khoi dong lai) van thu ngay.
+class PeerPool {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr std::chrono::milliseconds MAX_BACKOFF{1000};
+
+    struct Peer {
+        int id;
+        int sock = -1;
+        bool broken = false;        // ket noi truoc do da bi loi
+        bool unixFailed = false;    // peer tra loi qua TCP nhung khong lang nghe AF_UNIX; xoa khi ket noi dut
+        bool viaUnix = false;       // ket noi hien tai la AF_UNIX
+        Clock::time_point retryAt;  // chua thu connect lai truoc thoi diem nay
+        std::chrono::milliseconds backoff{0};
+        std::atomic<uint64_t> connectFailures{0};   // doc khong can khoa (metrics)
+        std::mutex mtx;
+    };
+
+private:
+    std::vector<std::unique_ptr<Peer>> peers;   // chi so la id, nullptr neu khong co peer
+    std::atomic<uint64_t> &connects;
+    std::atomic<uint64_t> &reconnects;
+    std::atomic<uint64_t> &syscalls;
+    std::chrono::milliseconds timeout;
+    int opt = 1;
+
+public:
+    PeerPool(std::atomic<uint64_t> &connects, std::atomic<uint64_t> &reconnects, std::atomic<uint64_t> &syscalls)
+        : connects(connects), reconnects(reconnects), syscalls(syscalls),
+          timeout(config.getConnectTimeoutMs()) {
+        std::shared_ptr<const PeerTable> table = config.getPeers();
+        peers.resize(table->size());
+        for (int peerId = 1; peerId < table->size(); peerId++) {
+            if (table->find(peerId) != nullptr) {
+                peers[peerId] = std::make_unique<Peer>();
+                peers[peerId]->id = peerId;
+            }
+        }
+    }
+
+    ~PeerPool() {
+        for (auto &peer : peers) {
+            if (peer && peer->sock >= 0) {
+                close(peer->sock);
+            }
+        }
+    }
+
+    Peer *find(int peerId) {
+        if (peerId <= 0 || peerId >= static_cast<int>(peers.size())) {
+            return nullptr;
+        }
+        return peers[peerId].get();
+    }
+
+    uint64_t connectFailures(int peerId) const {
+        if (peerId <= 0 || peerId >= static_cast<int>(peers.size()) || !peers[peerId]) {
+            return 0;
+        }
+        return peers[peerId]->connectFailures.load(std::memory_order_relaxed);
+    }
+
+    std::string describe(int peerId) {
+        Peer *peer = find(peerId);
+        if (peer == nullptr) {
+            return "unknown";
+        }
+        std::lock_guard<std::mutex> lock(peer->mtx);
+        if (peer->sock >= 0) {
+            return peer->viaUnix ? "unix" : "tcp";
+        }
+        std::shared_ptr<const PeerTable> table = config.getPeers();
+        const PeerAddress *address = table->find(peerId);
+        return (address != nullptr && address->local && !peer->unixFailed) ? "unix" : "tcp";
+    }
+
+    // goi khi da giu peer.mtx; trong khoang backoff tra ve false ngay
+    bool connectPeer(Peer &peer) {
+        std::shared_ptr<const PeerTable> table = config.getPeers();     // dia chi moi nhat, giu den het lan connect
+        const PeerAddress *address = table->find(peer.id);
+        if (address == nullptr) {
+            return false;
+        }
+        if (peer.backoff.count() > 0 && Clock::now() < peer.retryAt) {
+            return false;
+        }
+        // listener AF_UNIX vang mat (ECONNREFUSED) chi duoc ghi nho khi peer tra loi qua TCP ngay sau
+        // do; peer dang khoi dong lai (ca hai deu that bai) van duoc thu lai bang AF_UNIX lan sau
+        bool unixAbsent = false;
+        if (address->local && !peer.unixFailed) {
+            if (connectUnix(peer, *address, unixAbsent)) {
+                return true;
+            }
+        }
+        int clientSocket = socket(AF_INET, SOCK_STREAM, 0);
+        syscalls++;
+        if (clientSocket < 0) {
+            failed(peer, false);
+            return false;
+        }
+        bool timedOut = false;
+        if (!connectWithin(clientSocket, (const struct sockaddr*)&address->inetAddr, sizeof(address->inetAddr), timedOut)) {
+            close(clientSocket);
+            peer.broken = true;
+            failed(peer, timedOut);
+            return false;
+        }
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        peer.unixFailed = unixAbsent;
+        peer.viaUnix = false;
+        connected(peer, clientSocket);
+        return true;
+    }
+
+    void disconnect(Peer &peer) {
+        if (peer.sock >= 0) {
+            close(peer.sock);
+            syscalls++;
+        }
+        peer.sock = -1;
+        peer.broken = true;
+        peer.unixFailed = false;    // peer co the da khoi dong lai voi listener AF_UNIX
+    }
+
+    // peer khong doc (bo dem gui day qua SO_SNDTIMEO) cung tra ve false; nguoi goi ngat ket noi
+    bool writeAll(int sock, const char *data, size_t size) {
+        size_t sent = 0;
+        while (sent < size) {
+            ssize_t n = ::send(sock, data + sent, size - sent, MSG_NOSIGNAL);
+            syscalls++;
+            if (n <= 0) {
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+
+private:
+    bool connectUnix(Peer &peer, const PeerAddress &address, bool &absent) {
+        int clientSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        syscalls++;
+        if (clientSocket < 0) {
+            return false;
+        }
+        syscalls++;
+        if (connect(clientSocket, (const struct sockaddr*)&address.unixAddr, address.unixLength) < 0) {
+            absent = errno == ECONNREFUSED || errno == ENOENT;
+            close(clientSocket);
+            return false;
+        }
+        peer.viaUnix = true;
+        connected(peer, clientSocket);
+        return true;
+    }
+
+    // connect khong chan, cho toi da timeout; socket tro lai che do chan khi thanh cong
+    bool connectWithin(int sock, const struct sockaddr *addr, socklen_t length, bool &timedOut) {
+        int flags = fcntl(sock, F_GETFL, 0);
+        fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+        syscalls += 3;
+        if (connect(sock, addr, length) < 0) {
+            if (errno != EINPROGRESS) {
+                return false;
+            }
+            struct pollfd pfd = {sock, POLLOUT, 0};
+            syscalls += 2;
+            if (poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+                timedOut = true;
+                return false;
+            }
+            int error = 0;
+            socklen_t errorLength = sizeof(error);
+            if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &errorLength) < 0 || error != 0) {
+                return false;
+            }
+        }
+        fcntl(sock, F_SETFL, flags);
+        return true;
+    }
+
+    void failed(Peer &peer, bool timedOut) {
+        peer.connectFailures++;
+        if (timedOut) {
+            peer.backoff = peer.backoff.count() == 0 ? timeout : std::min(peer.backoff * 2, MAX_BACKOFF);
+            peer.retryAt = Clock::now() + peer.backoff;
+        }
+    }
+
+    void connected(Peer &peer, int clientSocket) {
+        struct timeval sendTimeout = {static_cast<time_t>(timeout.count() / 1000),
+                                      static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+        setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+        peer.backoff = std::chrono::milliseconds(0);
+        peer.sock = clientSocket;
+        connects++;
+        if (peer.broken) {
+            reconnects++;
+            peer.broken = false;
+        }
+    }
+};
+
+// Transport mac dinh: socket TCP, nhan bang vong lap epoll.
+// RECEIVE_WORKERS luong nhan, moi luong co socket lang nghe TCP rieng (SO_REUSEPORT, kernel
+// chia ket noi theo hash) va epoll rieng. Socket AF_UNIX khong chia theo reuseport duoc nen
+// dung chung, moi luong dang ky voi EPOLLEXCLUSIVE de chi mot luong duoc danh thuc accept.
+// Mot ket noi chi do mot luong doc, va moi peer gui tren mot ket noi, nen thu tu ban tin
+// tu moi nguon duoc giu; cac luong cung goi deliver song song (Comm chiu duoc nhieu luong ghi).
+class SocketTransport : public Transport {
+private:
+    struct Receiver {
+        int serverSocket = -1;
+        int epollFd = -1;
+        std::unordered_map<int, FrameDecoder> connections;   // socket da accept - bo ghep frame
+        std::thread thread;
+    };
+
+    int unixSocket;                               // lang nghe ket noi tu node cung may
+    int stopFd;                                   // eventfd dung de dung cac vong lap epoll
+    int opt = 1;
+    PeerPool peers;
+    std::vector<std::unique_ptr<Receiver>> receivers;
+    Deliver deliver;
+    BufferPool *pool = nullptr;
+
+public:
+    SocketTransport(int port, size_t workers = 1) : peers(connects, reconnects, syscalls) {
+        stopFd = eventfd(0, EFD_NONBLOCK);
+        if (stopFd < 0) {
+            throw std::runtime_error("Creating eventfd failed");
+        }
+        unixSocket = listenUnixSocket(port);
+        if (unixSocket >= 0) {
+            setNonBlocking(unixSocket);
+        }
+        try {
+            for (size_t i = 0; i < std::max<size_t>(1, workers); i++) {
+                auto receiver = std::make_unique<Receiver>();
+                receiver->serverSocket = listenSocket(port);
+                setNonBlocking(receiver->serverSocket);
+                receiver->epollFd = epoll_create1(0);
+                if (receiver->epollFd < 0) {
+                    close(receiver->serverSocket);
+                    throw std::runtime_error("Creating epoll failed");
+                }
+                receivers.push_back(std::move(receiver));
+                watch(*receivers.back(), receivers.back()->serverSocket);
+                watch(*receivers.back(), stopFd);
+                if (unixSocket >= 0) {
+                    watch(*receivers.back(), unixSocket, workers > 1 ? static_cast<uint32_t>(EPOLLEXCLUSIVE) : 0u);
+                }
+            }
+        }
+        catch (...) {
+            closeAll();
+            throw;
+        }
+    }
+
+    ~SocketTransport() {
+        uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Failed to stop receive thread\n";
+        }
+        for (auto &receiver : receivers) {
+            if (receiver->thread.joinable()) {
+                receiver->thread.join();
+            }
+        }
+        closeAll();
+    }
+
+    std::string name() const override {
+        return "socket";
+    }
+
+    std::string peerTransport(int peerId) override {
+        return peers.describe(peerId);
+    }
+
+    uint64_t connectFailures(int peerId) const override {
+        return peers.connectFailures(peerId);
+    }
+
+    void start(Deliver deliver, BufferPool &pool) override {
+        this->deliver = deliver;
+        this->pool = &pool;
+        for (auto &receiver : receivers) {
+            receiver->thread = std::thread(&SocketTransport::receiveThread, this, receiver.get());
+        }
+    }
+
+    bool send(int destId, const std::string &message) override {
+        PeerPool::Peer *peer = peers.find(destId);
+        if (peer == nullptr) {
+            return false;
+        }
+        std::string data = encodeFrame(message);
+
+        std::unique_lock<std::mutex> lock(peer->mtx);
+        // thu gui qua ket noi hien co, neu that bai thi ket noi lai va gui them mot lan
+        for (int attempt = 0; attempt < 2; attempt++) {
+            bool fresh = false;
+            if (peer->sock < 0) {
+                if (!peers.connectPeer(*peer)) {
+                    return false;
+                }
+                fresh = true;
+            }
+            if (peers.writeAll(peer->sock, data.data(), data.size())) {
+                if (!fresh) {
+                    reused++;
+                }
+                messagesSent++;
+                return true;
+            }
+            peers.disconnect(*peer);
+        }
+        return false;
+    }
+
+    static int listenSocket(int port) {
+        int serverSocket;
+        int opt = 1;
+        if ((serverSocket = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+            throw std::runtime_error("Creating socket failed");
+        }
+
+        struct sockaddr_in servaddr;
+        memset(&servaddr, 0, sizeof(servaddr));
+        servaddr.sin_family = AF_INET;
+        servaddr.sin_addr.s_addr = INADDR_ANY;
+        servaddr.sin_port = htons(port);
+
+        if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt))) {
+            throw std::runtime_error("Error setting socket options");
+        }
+
+        if (bind(serverSocket, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
+            close(serverSocket);
+            throw std::runtime_error("Bind failed");
+        }
+
+        if (::listen(serverSocket, SOMAXCONN) < 0) {
+            close(serverSocket);
+            throw std::runtime_error("Listen failed");
+        }
+        return serverSocket;
+    }
+
+    // socket AF_UNIX cho cac node cung may, tra ve -1 neu khong tao duoc (chi dung TCP)
+    static int listenUnixSocket(int port) {
+        int unixSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (unixSocket < 0) {
+            return -1;
+        }
+        sockaddr_un addr;
+        socklen_t len = unixAddress(port, addr);
+        if (bind(unixSocket, (struct sockaddr*)&addr, len) < 0 || ::listen(unixSocket, SOMAXCONN) < 0) {
+            std::cerr << "Unix socket for port " << port << " unavailable, local peers use TCP\n";
+            close(unixSocket);
+            return -1;
+        }
+        return unixSocket;
+    }
+
+    static void setNonBlocking(int sock) {
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+private:
+    void watch(Receiver &receiver, int fd, uint32_t flags = 0) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | flags;
+        ev.data.fd = fd;
+        if (epoll_ctl(receiver.epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            throw std::runtime_error("Error adding socket to epoll");
+        }
+    }
+
+    void closeAll() {
+        for (auto &receiver : receivers) {
+            for (auto &[sock, decoder] : receiver->connections) {
+                close(sock);
+            }
+            if (receiver->epollFd >= 0) {
+                close(receiver->epollFd);
+            }
+            if (receiver->serverSocket >= 0) {
+                close(receiver->serverSocket);
+            }
+        }
+        if (unixSocket >= 0) {
+            close(unixSocket);
+        }
+        close(stopFd);
+    }
+
+    // moi luong phuc vu socket lang nghe cua minh va cac ket noi no da accept
+    void receiveThread(Receiver *receiver) {
+        const int MAX_EVENTS = 64;
+        struct epoll_event events[MAX_EVENTS];
+        while (1) {
+            int n = epoll_wait(receiver->epollFd, events, MAX_EVENTS, -1);
+            syscalls++;
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Error waiting on epoll");
+            }
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == stopFd) {
+                    return;
+                } else if (fd == receiver->serverSocket || fd == unixSocket) {
+                    acceptConnections(*receiver, fd);
+                } else {
+                    readConnection(*receiver, fd);
+                }
+            }
+        }
+    }
+
+    void acceptConnections(Receiver &receiver, int listenSocket) {
+        while (1) {
+            int clientSocket = accept(listenSocket, nullptr, nullptr);
+            syscalls++;
+            if (clientSocket < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED || errno == EINTR) {
+                    return;
+                }
+                throw std::runtime_error("Error accepting connection");
+            }
+            setNonBlocking(clientSocket);
+            receiver.connections[clientSocket];
+            watch(receiver, clientSocket);
+            syscalls += 3;
+        }
+    }
+
+    // doc het du lieu dang co tren ket noi, giu lai phan frame con thieu cho lan sau
+    void readConnection(Receiver &receiver, int clientSocket) {
+        auto it = receiver.connections.find(clientSocket);
+        if (it == receiver.connections.end()) {
+            return;
+        }
+        FrameDecoder &decoder = it->second;
+        std::vector<Buffer> received;
+        Buffer message;
+        char buffer[4096];
+        bool closed = false;
+        while (1) {
+            ssize_t bytesRead = recv(clientSocket, buffer, sizeof(buffer), 0);
+            syscalls++;
+            if (bytesRead > 0) {
+                decoder.feed(buffer, bytesRead);
+                while (decoder.next(message, *pool)) {
+                    received.push_back(std::move(message));
+                }
+                if (decoder.isCorrupted()) {
+                    closed = true;
+                    break;
+                }
+            } else if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            } else {
+                closed = true;
+                break;
+            }
+        }
+
+        if (!received.empty()) {
+            messagesReceived += received.size();
+            deliver(received);
+        }
+        if (closed) {
+            epoll_ctl(receiver.epollFd, EPOLL_CTL_DEL, clientSocket, nullptr);
+            close(clientSocket);
+            receiver.connections.erase(it);
+            syscalls += 2;
+        }
+    }
+};
+
+#endif // TRANSPORT_H
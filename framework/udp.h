@@ -0,0 +1,238 @@
+// udp.h
+#ifndef UDP_H
+#define UDP_H
+
+#include "transport.h"
+#include "reliable.h"
+#include <poll.h>
+#include <sys/socket.h>
+
+// Transport UDP: moi ban tin la mot datagram. Do tin cay duoc dam bao boi ReliableEndpoint
+// (so thu tu theo peer, SACK, truyen lai theo timer, loai bo trung lap) va ban tin
+// duoc giao cho Comm dung thu tu gui. Broadcast va ACK duoc gom bang sendmmsg/recvmmsg.
+class UdpTransport : public Transport {
+private:
+    static const size_t MAX_DATAGRAM = 65507;
+    static const int BATCH = 32;
+
+    ReliableEndpoint endpoint;                  // dia chi peer lay tu config.getPeers() moi lan gui
+    int sock;
+    int stopFd;
+    Deliver deliver;
+    BufferPool *pool = nullptr;
+    std::thread m_receiveThread;
+
+public:
+    UdpTransport(int id, int port)
+        : endpoint(id, config.getReliableRetries(), std::chrono::milliseconds(config.getReliableMaxRtoMs())) {
+        if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+            throw std::runtime_error("Creating socket failed");
+        }
+        int opt = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        int bufferSize = 4 * 1024 * 1024;
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+        struct sockaddr_in servaddr;
+        memset(&servaddr, 0, sizeof(servaddr));
+        servaddr.sin_family = AF_INET;
+        servaddr.sin_addr.s_addr = INADDR_ANY;
+        servaddr.sin_port = htons(port);
+        if (bind(sock, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
+            close(sock);
+            throw std::runtime_error("Bind failed");
+        }
+        stopFd = eventfd(0, EFD_NONBLOCK);
+        if (stopFd < 0) {
+            close(sock);
+            throw std::runtime_error("Creating eventfd failed");
+        }
+    }
+
+    ~UdpTransport() {
+        uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Failed to stop receive thread\n";
+        }
+        if (m_receiveThread.joinable()) {
+            m_receiveThread.join();
+        }
+        close(stopFd);
+        close(sock);
+    }
+
+    std::string name() const override {
+        return "udp";
+    }
+
+    void start(Deliver deliver, BufferPool &pool) override {
+        this->deliver = deliver;
+        this->pool = &pool;
+        m_receiveThread = std::thread(&UdpTransport::receiveThread, this);
+    }
+
+    bool send(int destId, const std::string &message) override {
+        return sendReliable({destId}, message)[0];
+    }
+
+    std::vector<bool> sendMany(const std::vector<int> &dests, const std::string &message) override {
+        return sendReliable(dests, message);
+    }
+
+    // ReliableLink giao ban tin theo thu tu seq
+    bool preservesOrder() const override {
+        return true;
+    }
+
+    // sendmmsg chi dua datagram vao kernel, truyen lai do luong nhan lo
+    bool sendMayBlock() const override {
+        return false;
+    }
+
+private:
+    // danh so thu tu, luu lai de truyen lai roi gui tat ca datagram bang mot sendmmsg.
+    // Ban tin da danh so duoc coi la gui thanh cong, ReliableLink lo viec truyen lai.
+    std::vector<bool> sendReliable(const std::vector<int> &dests, const std::string &message) {
+        std::vector<bool> results(dests.size(), false);
+        if (message.size() + ReliableEndpoint::DATA_HEADER > MAX_DATAGRAM) {
+            return results;
+        }
+        auto now = ReliableEndpoint::Clock::now();
+        std::vector<std::string> packets;
+        std::vector<sockaddr_in> addrs;
+        packets.reserve(dests.size());
+        std::shared_ptr<const PeerTable> table = config.getPeers();
+        for (size_t i = 0; i < dests.size(); i++) {
+            const PeerAddress *address = table->find(dests[i]);
+            std::string packet;
+            if (address == nullptr || !endpoint.data(dests[i], message, now, packet)) {
+                continue;
+            }
+            results[i] = true;
+            packets.push_back(std::move(packet));
+            addrs.push_back(address->inetAddr);
+        }
+        if (packets.empty()) {
+            return results;
+        }
+        std::vector<const std::string *> views;
+        for (auto &p : packets) {
+            views.push_back(&p);
+        }
+        sendBatch(views, addrs);
+        messagesSent += packets.size();
+        return results;
+    }
+
+    // gui nhieu datagram bang mot lan sendmmsg
+    void sendBatch(const std::vector<const std::string *> &packets, const std::vector<sockaddr_in> &addrs) {
+        size_t begin = 0;
+        while (begin < packets.size()) {
+            size_t count = std::min(packets.size() - begin, static_cast<size_t>(UIO_MAXIOV));
+            std::vector<mmsghdr> msgs(count);
+            std::vector<iovec> iovs(count);
+            for (size_t i = 0; i < count; i++) {
+                iovs[i].iov_base = const_cast<char *>(packets[begin + i]->data());
+                iovs[i].iov_len = packets[begin + i]->size();
+                memset(&msgs[i], 0, sizeof(mmsghdr));
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_name = const_cast<sockaddr_in *>(&addrs[begin + i]);
+                msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            }
+            syscalls++;
+            int sent = sendmmsg(sock, msgs.data(), count, 0);
+            // goi tin khong gui duoc se duoc truyen lai boi timer
+            begin += (sent > 0) ? sent : count;
+        }
+    }
+
+    void receiveThread() {
+        std::vector<std::vector<char>> buffers(BATCH, std::vector<char>(MAX_DATAGRAM));
+        std::vector<mmsghdr> msgs(BATCH);
+        std::vector<iovec> iovs(BATCH);
+        std::vector<Buffer> ready;
+        std::vector<ReliableEndpoint::Outgoing> out;
+
+        struct pollfd fds[2];
+        fds[0].fd = sock;
+        fds[0].events = POLLIN;
+        fds[1].fd = stopFd;
+        fds[1].events = POLLIN;
+
+        while (1) {
+            syscalls++;
+            int n = poll(fds, 2, ReliableEndpoint::TICK_MS);
+            if (n < 0 && errno != EINTR) {
+                throw std::runtime_error("Error polling udp socket");
+            }
+            if (n > 0 && (fds[1].revents & POLLIN)) {
+                return;
+            }
+            if (n > 0 && (fds[0].revents & POLLIN)) {
+                while (1) {
+                    for (int i = 0; i < BATCH; i++) {
+                        iovs[i].iov_base = buffers[i].data();
+                        iovs[i].iov_len = buffers[i].size();
+                        memset(&msgs[i], 0, sizeof(mmsghdr));
+                        msgs[i].msg_hdr.msg_iov = &iovs[i];
+                        msgs[i].msg_hdr.msg_iovlen = 1;
+                    }
+                    syscalls++;
+                    int count = recvmmsg(sock, msgs.data(), BATCH, MSG_DONTWAIT, nullptr);
+                    if (count <= 0) {
+                        break;
+                    }
+                    for (int i = 0; i < count; i++) {
+                        handlePacket(buffers[i].data(), msgs[i].msg_len, ready);
+                    }
+                    if (count < BATCH) {
+                        break;
+                    }
+                }
+            }
+            // ACK cho lo vua nhan, va moi TICK_MS cac goi qua han
+            flush(out);
+            if (!ready.empty()) {
+                messagesReceived += ready.size();
+                deliver(ready);
+                ready.clear();
+            }
+        }
+    }
+
+    void handlePacket(const char *data, size_t size, std::vector<Buffer> &ready) {
+        ReliableEndpoint::Received received = endpoint.receive(data, size, [this, data, size]() {
+            return pool->copy(data + ReliableEndpoint::DATA_HEADER, size - ReliableEndpoint::DATA_HEADER);
+        }, ready);
+        if (received == ReliableEndpoint::DUPLICATE) {
+            duplicates++;
+        }
+    }
+
+    // gui ACK va goi truyen lai cua endpoint bang mot lo sendmmsg
+    void flush(std::vector<ReliableEndpoint::Outgoing> &out) {
+        std::vector<std::pair<int, size_t>> failed;
+        retransmits += endpoint.flush(ReliableEndpoint::Clock::now(), out, failed);
+        for (auto &[peerId, count] : failed) {
+            reportFailure(peerId, count);
+        }
+        if (out.empty()) {
+            return;
+        }
+        std::vector<const std::string *> views;
+        std::vector<sockaddr_in> addrs;
+        std::shared_ptr<const PeerTable> table = config.getPeers();
+        for (auto &packet : out) {
+            const PeerAddress *address = table->find(packet.peerId);
+            if (address != nullptr) {
+                views.push_back(&packet.packet);
+                addrs.push_back(address->inetAddr);
+            }
+        }
+        sendBatch(views, addrs);
+        out.clear();
+    }
+};
+
+#endif // UDP_H
@@ -0,0 +1,546 @@
+// uring.h
+#ifndef URING_H
+#define URING_H
+
+#include "transport.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <initializer_list>
+#include <algorithm>
+#include <cstdint>
+
+// Lop bao io_uring toi thieu, goi system call truc tiep (khong can liburing).
+// Khong an toan voi nhieu luong: moi ring chi duoc dung boi mot luong tai mot thoi diem.
+class IoUring {
+private:
+    int ringFd = -1;
+    io_uring_params params;
+    void *sqPtr = MAP_FAILED;
+    void *cqPtr = MAP_FAILED;
+    size_t sqSize = 0;
+    size_t cqSize = 0;
+    io_uring_sqe *sqes = (io_uring_sqe*)MAP_FAILED;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_cqe *cqes;
+    unsigned localTail;
+    unsigned pending = 0;           // so sqe da dien nhung chua submit
+
+public:
+    explicit IoUring(unsigned entries) {
+        memset(&params, 0, sizeof(params));
+        ringFd = syscall(__NR_io_uring_setup, entries, &params);
+        if (ringFd < 0) {
+            throw std::runtime_error("io_uring_setup failed");
+        }
+        sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            sqSize = cqSize = std::max(sqSize, cqSize);
+        }
+        sqPtr = mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        cqPtr = singleMmap ? sqPtr : mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        sqes = (io_uring_sqe*)mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqPtr == MAP_FAILED || cqPtr == MAP_FAILED || sqes == MAP_FAILED) {
+            release();
+            throw std::runtime_error("Mapping io_uring failed");
+        }
+
+        char *sq = (char*)sqPtr;
+        sqHead = (unsigned*)(sq + params.sq_off.head);
+        sqTail = (unsigned*)(sq + params.sq_off.tail);
+        sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+        sqArray = (unsigned*)(sq + params.sq_off.array);
+        char *cq = (char*)cqPtr;
+        cqHead = (unsigned*)(cq + params.cq_off.head);
+        cqTail = (unsigned*)(cq + params.cq_off.tail);
+        cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+        localTail = *sqTail;
+    }
+
+    ~IoUring() {
+        release();
+    }
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    unsigned entries() const {
+        return params.sq_entries;
+    }
+
+    // kiem tra kernel co ho tro cac opcode can dung hay khong
+    bool supports(std::initializer_list<int> ops) {
+        const int MAX_OPS = 256;
+        std::vector<char> storage(sizeof(io_uring_probe) + MAX_OPS * sizeof(io_uring_probe_op), 0);
+        io_uring_probe *probe = (io_uring_probe*)storage.data();
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, MAX_OPS) < 0) {
+            return false;
+        }
+        for (int op : ops) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool registerBuffers(const std::vector<iovec> &iovs) {
+        return syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, iovs.data(), iovs.size()) == 0;
+    }
+
+    // lay mot sqe trong, neu hang doi submit da day thi submit bot truoc
+    io_uring_sqe *getSqe() {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (localTail - head >= params.sq_entries) {
+            submitAndWait(0);
+            head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            if (localTail - head >= params.sq_entries) {
+                throw std::runtime_error("io_uring submission queue is full");
+            }
+        }
+        unsigned index = localTail & *sqMask;
+        io_uring_sqe *sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        localTail++;
+        pending++;
+        return sqe;
+    }
+
+    // submit tat ca sqe dang cho va doi it nhat waitNr ket qua trong cung mot system call
+    int submitAndWait(unsigned waitNr) {
+        __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+        unsigned toSubmit = pending;
+        pending = 0;
+        unsigned flags = waitNr > 0 ? IORING_ENTER_GETEVENTS : 0;
+        while (1) {
+            int ret = syscall(__NR_io_uring_enter, ringFd, toSubmit, waitNr, flags, nullptr, 0);
+            if (ret >= 0 || errno != EINTR) {
+                return ret;
+            }
+            toSubmit = 0;
+        }
+    }
+
+    bool peekCqe(io_uring_cqe &cqe) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        cqe = cqes[head & *cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    void release() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+        }
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr) {
+            munmap(cqPtr, cqSize);
+        }
+        if (sqPtr != MAP_FAILED) {
+            munmap(sqPtr, sqSize);
+        }
+        if (ringFd >= 0) {
+            close(ringFd);
+        }
+        sqes = (io_uring_sqe*)MAP_FAILED;
+        sqPtr = cqPtr = MAP_FAILED;
+        ringFd = -1;
+    }
+};
+
+// Transport dung io_uring: accept/recv/send duoc gom thanh lo, mot lan io_uring_enter
+// submit ca lo va lay ket qua. Bo dem nhan duoc dang ky truoc voi kernel (fixed buffers);
+// ban tin gui bang IORING_OP_SEND thang tu frame cua nguoi gui. Comm gui qua Outbox nen moi
+// IO worker gui toi mot dich; SEND cua cac worker gui cung luc duoc gom vao mot lan submit.
+class UringTransport : public Transport {
+private:
+    enum Kind : uint64_t { ACCEPT = 1, RECV = 2, STOP = 3 };
+
+    struct Connection {
+        FrameDecoder decoder;
+        int bufferIndex = -1;               // -1: khong con fixed buffer, dung heapBuffer
+        std::vector<char> heapBuffer;
+    };
+
+    static const unsigned RING_ENTRIES = 256;
+    static const unsigned RECV_BUFFERS = 64;
+    static const size_t BUFFER_SIZE = 16 * 1024;
+
+    // mot SEND dang cho submit; luong dang giu sendMutex dien ket qua thay cho nguoi gui
+    struct SendRequest {
+        int sock;
+        const char *data;
+        size_t size;
+        int result = 0;
+        bool done = false;
+    };
+
+    std::vector<char> recvMemory;
+    std::vector<int> freeRecvBuffers;
+    IoUring recvRing;                        // chi luong nhan dung
+    IoUring sendRing;                        // dung chung, bao ve boi sendMutex
+    std::mutex sendMutex;                    // chi giu trong luc submit va doi ket qua
+    std::mutex pendingMutex;
+    std::vector<SendRequest*> pending;       // SEND cho luong giu sendMutex submit
+    PeerPool peers;
+
+    int serverSocket = -1;
+    int unixSocket = -1;
+    int stopFd = -1;
+    uint64_t stopValue = 0;
+    std::unordered_map<int, Connection> connections;
+    Deliver deliver;
+    BufferPool *pool = nullptr;
+    std::thread m_receiveThread;
+
+public:
+    UringTransport(int port)
+        : recvRing(RING_ENTRIES), sendRing(RING_ENTRIES), peers(connects, reconnects, syscalls) {
+        if (!recvRing.supports({IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_READ, IORING_OP_READ_FIXED, IORING_OP_SEND})) {
+            throw std::runtime_error("io_uring opcodes not supported");
+        }
+        recvMemory.resize(RECV_BUFFERS * BUFFER_SIZE);
+        if (!recvRing.registerBuffers(makeIovecs(recvMemory, RECV_BUFFERS))) {
+            throw std::runtime_error("Registering io_uring buffers failed");
+        }
+        for (int i = RECV_BUFFERS - 1; i >= 0; i--) {
+            freeRecvBuffers.push_back(i);
+        }
+
+        stopFd = eventfd(0, 0);
+        if (stopFd < 0) {
+            throw std::runtime_error("Creating eventfd failed");
+        }
+        // AF_UNIX truoc TCP: peer thay cong TCP mo thi listener AF_UNIX cung da co
+        unixSocket = SocketTransport::listenUnixSocket(port);
+        serverSocket = SocketTransport::listenSocket(port);
+    }
+
+    ~UringTransport() {
+        uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0) {
+            std::cerr << "Failed to stop receive thread\n";
+        }
+        if (m_receiveThread.joinable()) {
+            m_receiveThread.join();
+        }
+        for (auto &[sock, conn] : connections) {
+            close(sock);
+        }
+        close(stopFd);
+        close(serverSocket);
+        if (unixSocket >= 0) {
+            close(unixSocket);
+        }
+    }
+
+    std::string name() const override {
+        return "uring";
+    }
+
+    std::string peerTransport(int peerId) override {
+        return "uring/" + peers.describe(peerId);
+    }
+
+    uint64_t connectFailures(int peerId) const override {
+        return peers.connectFailures(peerId);
+    }
+
+    void start(Deliver deliver, BufferPool &pool) override {
+        this->deliver = deliver;
+        this->pool = &pool;
+        m_receiveThread = std::thread(&UringTransport::receiveThread, this);
+    }
+
+    bool send(int destId, const std::string &message) override {
+        std::vector<bool> results;
+        sendBatch({destId}, message, results);
+        return results[0];
+    }
+
+    std::vector<bool> sendMany(const std::vector<int> &dests, const std::string &message) override {
+        std::vector<bool> results;
+        sendBatch(dests, message, results);
+        return results;
+    }
+
+private:
+    static std::vector<iovec> makeIovecs(std::vector<char> &memory, unsigned count) {
+        std::vector<iovec> iovs(count);
+        for (unsigned i = 0; i < count; i++) {
+            iovs[i].iov_base = memory.data() + i * BUFFER_SIZE;
+            iovs[i].iov_len = BUFFER_SIZE;
+        }
+        return iovs;
+    }
+
+    static uint64_t tag(Kind kind, int fd) {
+        return (static_cast<uint64_t>(kind) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    // Gui ban tin toi cac dich. Luong goi giu khoa cua tung peer dich (theo thu tu id) trong
+    // luc connect va gui du phong, nen peer chet chi chan cac lan gui toi chinh no. SEND duoc
+    // dua vao hang cho chung; luong nao lay duoc sendMutex thi submit ca hang cho (cua minh va
+    // cua cac IO worker khac) bang mot lan io_uring_enter, roi moi luong tu xu ly ket qua cua minh.
+    void sendBatch(const std::vector<int> &dests, const std::string &message, std::vector<bool> &results) {
+        std::string frame = encodeFrame(message);
+        results.assign(dests.size(), false);
+
+        std::vector<size_t> order(dests.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&dests](size_t a, size_t b) { return dests[a] < dests[b]; });
+        struct Target {
+            PeerPool::Peer *peer;
+            bool pooled;                    // ket noi co san: chi tinh reused khi gui xong
+            size_t request;
+        };
+        std::vector<std::unique_lock<std::mutex>> locks;
+        std::vector<Target> targets;        // moi peer mot lan, dich trung lap dung chung ket qua
+        std::vector<size_t> targetOf(dests.size(), SIZE_MAX);
+        std::vector<SendRequest> requests;
+        requests.reserve(dests.size());
+        for (size_t i : order) {
+            if (!targets.empty() && targets.back().peer->id == dests[i]) {
+                targetOf[i] = targets.size() - 1;
+                continue;
+            }
+            PeerPool::Peer *peer = peers.find(dests[i]);
+            if (peer == nullptr) {
+                continue;
+            }
+            locks.emplace_back(peer->mtx);
+            bool fresh = peer->sock < 0;
+            if (fresh && !peers.connectPeer(*peer)) {
+                continue;
+            }
+            targetOf[i] = targets.size();
+            targets.push_back({peer, !fresh, requests.size()});
+            requests.push_back({peer->sock, frame.data(), frame.size()});
+        }
+
+        if (!requests.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(pendingMutex);
+                for (auto &request : requests) {
+                    pending.push_back(&request);
+                }
+            }
+            std::lock_guard<std::mutex> lock(sendMutex);
+            if (!requests.back().done) {
+                submitPending();
+            }
+        }
+
+        std::vector<bool> sent(targets.size(), false);
+        for (size_t t = 0; t < targets.size(); t++) {
+            PeerPool::Peer &peer = *targets[t].peer;
+            int res = requests[targets[t].request].result;
+            if (res == static_cast<int>(frame.size())) {
+                sent[t] = true;
+            } else if (res > 0 || res == -EAGAIN) {
+                // bo dem gui day: gui not bang send chan, gioi han boi SO_SNDTIMEO
+                size_t done = res > 0 ? res : 0;
+                sent[t] = peers.writeAll(peer.sock, frame.data() + done, frame.size() - done);
+                if (!sent[t]) {
+                    peers.disconnect(peer);
+                }
+            } else {
+                peers.disconnect(peer);
+                sent[t] = writeWithRetry(peer, frame, false);
+                continue;
+            }
+            reused += sent[t] && targets[t].pooled ? 1 : 0;
+        }
+        for (size_t i = 0; i < dests.size(); i++) {
+            if (targetOf[i] != SIZE_MAX && sent[targetOf[i]]) {
+                results[i] = true;
+                messagesSent++;
+            }
+        }
+    }
+
+    // goi khi giu sendMutex: submit moi SEND dang cho, moi lo toi da bang so entry cua ring
+    void submitPending() {
+        std::vector<SendRequest*> batch;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            batch.swap(pending);
+        }
+        for (size_t begin = 0; begin < batch.size(); begin += sendRing.entries()) {
+            size_t count = std::min<size_t>(sendRing.entries(), batch.size() - begin);
+            for (size_t slot = 0; slot < count; slot++) {
+                SendRequest &request = *batch[begin + slot];
+                // SEND thay cho WRITE_FIXED de co MSG_NOSIGNAL: ghi vao ket noi peer vua
+                // khoi dong lai se tra ve -EPIPE thay vi SIGPIPE giet ca tien trinh.
+                // MSG_DONTWAIT: peer khong doc khong giu ca lo, phan con lai nguoi gui tu gui co han
+                io_uring_sqe *sqe = sendRing.getSqe();
+                sqe->opcode = IORING_OP_SEND;
+                sqe->fd = request.sock;
+                sqe->addr = reinterpret_cast<uint64_t>(request.data);
+                sqe->len = request.size;
+                sqe->msg_flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+                sqe->user_data = slot;
+            }
+
+            syscalls++;
+            if (sendRing.submitAndWait(count) < 0) {
+                // chua gui duoc gi, ket noi van dung: nguoi gui tu gui bang send chan
+                for (size_t slot = 0; slot < count; slot++) {
+                    batch[begin + slot]->result = -EAGAIN;
+                    batch[begin + slot]->done = true;
+                }
+                continue;
+            }
+            size_t done = 0;
+            io_uring_cqe cqe;
+            while (done < count) {
+                if (!sendRing.peekCqe(cqe)) {
+                    syscalls++;
+                    sendRing.submitAndWait(1);
+                    continue;
+                }
+                done++;
+                SendRequest &request = *batch[begin + cqe.user_data];
+                request.result = cqe.res;
+                request.done = true;
+            }
+        }
+    }
+
+    // duong gui du phong khi io_uring bao loi (goi khi giu peer.mtx): ket noi lai va gui dong bo.
+    // pooled: ket noi dang mo co tu truoc lan gui nay (tinh reused neu gui duoc tren no)
+    bool writeWithRetry(PeerPool::Peer &peer, const std::string &frame, bool pooled) {
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (peer.sock < 0) {
+                if (!peers.connectPeer(peer)) {
+                    return false;
+                }
+                pooled = false;
+            }
+            if (peers.writeAll(peer.sock, frame.data(), frame.size())) {
+                reused += pooled ? 1 : 0;
+                return true;
+            }
+            peers.disconnect(peer);
+        }
+        return false;
+    }
+
+    void prepareAccept(int listenSocket) {
+        io_uring_sqe *sqe = recvRing.getSqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listenSocket;
+        sqe->user_data = tag(ACCEPT, listenSocket);
+    }
+
+    void prepareRecv(int sock, Connection &conn) {
+        io_uring_sqe *sqe = recvRing.getSqe();
+        sqe->fd = sock;
+        sqe->user_data = tag(RECV, sock);
+        if (conn.bufferIndex >= 0) {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(recvMemory.data() + conn.bufferIndex * BUFFER_SIZE);
+            sqe->len = BUFFER_SIZE;
+            sqe->buf_index = conn.bufferIndex;
+        } else {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->addr = reinterpret_cast<uint64_t>(conn.heapBuffer.data());
+            sqe->len = conn.heapBuffer.size();
+        }
+    }
+
+    void prepareStop() {
+        io_uring_sqe *sqe = recvRing.getSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = stopFd;
+        sqe->addr = reinterpret_cast<uint64_t>(&stopValue);
+        sqe->len = sizeof(stopValue);
+        sqe->user_data = tag(STOP, stopFd);
+    }
+
+    // moi vong lap: mot io_uring_enter submit cac yeu cau moi va doi ket qua
+    void receiveThread() {
+        prepareAccept(serverSocket);
+        if (unixSocket >= 0) {
+            prepareAccept(unixSocket);
+        }
+        prepareStop();
+        std::vector<Buffer> received;
+        while (1) {
+            syscalls++;
+            if (recvRing.submitAndWait(1) < 0) {
+                throw std::runtime_error("Error waiting on io_uring");
+            }
+            io_uring_cqe cqe;
+            while (recvRing.peekCqe(cqe)) {
+                Kind kind = static_cast<Kind>(cqe.user_data >> 32);
+                int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+                if (kind == STOP) {
+                    return;
+                } else if (kind == ACCEPT) {
+                    if (cqe.res >= 0) {
+                        accepted(cqe.res);
+                    }
+                    prepareAccept(fd);
+                } else if (kind == RECV) {
+                    readCompleted(fd, cqe.res, received);
+                }
+            }
+            if (!received.empty()) {
+                messagesReceived += received.size();
+                deliver(received);
+                received.clear();
+            }
+        }
+    }
+
+    void accepted(int sock) {
+        Connection &conn = connections[sock];
+        if (!freeRecvBuffers.empty()) {
+            conn.bufferIndex = freeRecvBuffers.back();
+            freeRecvBuffers.pop_back();
+        } else {
+            conn.heapBuffer.resize(BUFFER_SIZE);
+        }
+        prepareRecv(sock, conn);
+    }
+
+    void readCompleted(int sock, int res, std::vector<Buffer> &received) {
+        auto it = connections.find(sock);
+        if (it == connections.end()) {
+            return;
+        }
+        Connection &conn = it->second;
+        if (res > 0) {
+            const char *data = conn.bufferIndex >= 0 ? recvMemory.data() + conn.bufferIndex * BUFFER_SIZE : conn.heapBuffer.data();
+            conn.decoder.feed(data, res);
+            Buffer message;
+            while (conn.decoder.next(message, *pool)) {
+                received.push_back(std::move(message));
+            }
+            if (!conn.decoder.isCorrupted()) {
+                prepareRecv(sock, conn);
+                return;
+            }
+        }
+        if (conn.bufferIndex >= 0) {
+            freeRecvBuffers.push_back(conn.bufferIndex);
+        }
+        close(sock);
+        syscalls++;
+        connections.erase(it);
+    }
+};
+
+#endif // URING_H
@@ -0,0 +1,39 @@
+// Chuyen log nhi phan (LOG_FORMAT=binary) ve dong JSON nhu LOG_FORMAT=json
+// g++ logconvert.cpp -o logconvert -Iframework
+// ./logconvert log_1.txt log_2.txt ... > log.txt  (roi dung ./sort log.txt nhu binh thuong)
+
+#include "logformat.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " file..." << endl;
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        ifstream input(argv[i], ios::binary);
+        if (!input.is_open()) {
+            cerr << "Loi mo file " << argv[i] << "!" << endl;
+            return 1;
+        }
+        string data((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+
+        BinaryLog::Decoder decoder(data.data(), data.size());
+        string line;
+        try {
+            while (decoder.next(line)) {
+                cout << line << '\n';
+            }
+        } catch (const exception& e) {
+            cerr << argv[i] << ": " << e.what();
+            return 1;
+        }
+    }
+    return 0;
+}
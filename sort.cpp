@@ -21,8 +21,8 @@ std::chrono::milliseconds parse_time_to_milliseconds(const std::string& timeStr)
 }
 
 bool compare_by_total_time_ms(const json& a, const json& b) {
-    auto timeA = parse_time_to_milliseconds(a["time"]);
-    auto timeB = parse_time_to_milliseconds(b["time"]);
+    auto timeA = parse_time_to_milliseconds(a["timeInit"]);
+    auto timeB = parse_time_to_milliseconds(b["timeInit"]);
 
     // Tổng thời gian: thời gian gốc + duration_ms (đã ở dạng mili giây)
     std::chrono::milliseconds totalA = timeA + std::chrono::milliseconds(a["duration_ms"].get<int>());
@@ -31,30 +31,41 @@ bool compare_by_total_time_ms(const json& a, const json& b) {
     return totalA < totalB;
 }
 
-int main() {
-    ifstream input("log.txt");
-    ofstream output("output_log.txt");
-
-    // Kiểm tra xem file input có mở được không
-    if (!input.is_open()) {
-        cerr << "Lỗi mở file log.txt!" << endl;
-        return 1;
+// ./sort log_1.txt log_2.txt ... : gop log cua cac node (LOG_FILE) roi sap xep; mac dinh log.txt
+int main(int argc, char* argv[]) {
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        files.push_back("log.txt");
     }
+    ofstream output("output_log.txt");
 
     vector<json> logs;
     string line;
 
-    while (getline(input, line)) {
-        if (line.empty()) {
-            continue; // Bỏ qua dòng trống
+    for (const auto& file : files) {
+        ifstream input(file);
+
+        // Kiểm tra xem file input có mở được không
+        if (!input.is_open()) {
+            cerr << "Lỗi mở file " << file << "!" << endl;
+            return 1;
         }
 
-        try {
-            json log = json::parse(line); // Thử phân tích JSON
-            logs.push_back(log);
-        } catch (const json::parse_error& e) {
-            cerr << "Lỗi phân tích dòng: " << line << " - " << e.what() << endl;
-            continue; // Bỏ qua dòng không hợp lệ
+        while (getline(input, line)) {
+            if (line.empty()) {
+                continue; // Bỏ qua dòng trống
+            }
+
+            try {
+                json log = json::parse(line); // Thử phân tích JSON
+                logs.push_back(log);
+            } catch (const json::parse_error& e) {
+                cerr << "Lỗi phân tích dòng: " << line << " - " << e.what() << endl;
+                continue; // Bỏ qua dòng không hợp lệ
+            }
         }
     }
 